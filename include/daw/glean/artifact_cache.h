@@ -0,0 +1,76 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+
+#include "action_status.h"
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief The installed files of dependency builds, kept in a folder that
+	/// many machines can share, such as a network mount.  Each archive is named
+	/// by a digest of everything that decides what was built, and is never
+	/// changed once written.  A sha256 of each archive's content is kept next
+	/// to it and checked before it is used
+	class artifact_cache {
+		fs::path m_root{};
+
+		[[nodiscard]] fs::path digest_path( std::string const &key ) const;
+
+	public:
+		explicit artifact_cache( fs::path root );
+
+		/// @brief Whether key has an archive and the digest of its content
+		[[nodiscard]] bool contains( std::string const &key ) const;
+
+		[[nodiscard]] fs::path archive_path( std::string const &key ) const;
+
+		/// @brief The sha256_file_hex of the archive of key, empty when there is
+		/// none
+		[[nodiscard]] std::string digest( std::string const &key ) const;
+
+		/// @brief A new file to write an archive of key to before commit moves it
+		/// into place.  Other machines may be writing the same key
+		[[nodiscard]] fs::path partial_path( std::string const &key ) const;
+
+		/// @brief Make the complete archive written to partial the one of key and
+		/// record its digest.  An existing archive is never replaced, partial is
+		/// removed instead and the result is false
+		[[nodiscard]] bool commit( fs::path const &partial,
+		                           std::string const &key ) const;
+
+		/// @brief Unpack the archive of key into install_root and list what it
+		/// held in manifest, as the install that made it would have.  Fails when
+		/// the archive does not match its digest
+		[[nodiscard]] action_status restore( std::string const &key,
+		                                     fs::path const &install_root,
+		                                     fs::path const &manifest ) const;
+
+		/// @brief Archive the files listed in manifest under key.  They must all
+		/// be within install_root
+		[[nodiscard]] action_status store( std::string const &key,
+		                                   fs::path const &install_root,
+		                                   fs::path const &manifest ) const;
+	};
+} // namespace daw::glean
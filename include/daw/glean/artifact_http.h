@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "action_status.h"
+#include "artifact_cache.h"
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief Serve the archives of an artifact cache over plain HTTP, keyed by
+	/// their digest.
+	///   HEAD /<key> whether the archive exists
+	///   GET /<key>  the archive
+	///   PUT /<key>  store an archive, 409 when the key already has one
+	/// Uploads and downloads carry the sha256 of the archive in an
+	/// X-Glean-Sha256 header, which the receiver checks.  At most 32
+	/// connections are handled at once and a connection that stalls for a
+	/// minute is closed.  Runs until glean is stopped
+	[[nodiscard]] action_status serve_artifact_cache( artifact_cache const &store,
+	                                                  std::string const &address,
+	                                                  uint16_t port );
+
+	/// @brief Client of serve_artifact_cache.  Every request uses its own
+	/// connection and at most max_transfers run at once, the rest wait.  A
+	/// download that does not match the digest the server sent fails
+	class artifact_client {
+		std::string m_host{};
+		std::string m_port{};
+		std::string m_base_path{};
+		std::mutex m_mutex{};
+		std::condition_variable m_has_slot{};
+		uint32_t m_free_slots = 1;
+
+		class transfer_slot;
+
+	public:
+		/// @param url server location, such as http://cache.local:8765
+		artifact_client( std::string const &url, uint32_t max_transfers );
+
+		[[nodiscard]] bool contains( std::string const &key );
+
+		/// @brief Save the archive of key to file
+		[[nodiscard]] action_status download( std::string const &key,
+		                                      fs::path const &file );
+
+		/// @brief Send file to the server as the archive of key
+		[[nodiscard]] action_status upload( std::string const &key,
+		                                    fs::path const &file );
+	};
+} // namespace daw::glean
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <daw/daw_string_view.h>
 
 #include "action_status.h"
@@ -37,13 +40,37 @@ namespace daw::glean {
 		fs::path m_install_prefix{};
 		glean_options const *m_opt = nullptr;
 		bool m_has_glean;
+		// Decided once, so that every build type of a run agrees on the folder
+		bool m_multi_config = false;
 
 		build_cmake( fs::path const &cache_path, fs::path const &install_prefix,
-		             glean_options const &opts, bool has_glean ) noexcept;
+		             glean_options const &opts, bool has_glean );
 
 		[[nodiscard]] action_status build( daw::glean::build_types bt,
 		                                   glean_file_item const &file_dep ) const;
-		[[nodiscard]] action_status install( daw::glean::build_types bt ) const;
+		[[nodiscard]] action_status
+		install( daw::glean::build_types bt,
+		         glean_file_item const &file_dep ) const;
+
+		/// @brief The effective configure command line, everything that decides
+		/// what is built other than the source and the dependencies
+		[[nodiscard]] std::vector<std::string>
+		build_inputs( daw::glean::build_types bt,
+		              glean_file_item const &file_dep ) const;
+
+		/// @brief Every build type is built from one Ninja Multi-Config folder.
+		/// Only for dependencies without glean dependencies, a single configure
+		/// can only find one build type of those, and not for one whose debug
+		/// install named the release prefix in a previous run
+		[[nodiscard]] bool is_multi_config( ) const;
+
+		/// @brief Every file the last install reported is still present
+		[[nodiscard]] bool is_installed( daw::glean::build_types bt ) const;
+
+		/// @brief The list of files the last install wrote, one absolute path
+		/// per line
+		[[nodiscard]] fs::path
+		install_manifest( daw::glean::build_types bt ) const;
 	};
 
 } // namespace daw::glean
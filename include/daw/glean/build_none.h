@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <daw/daw_string_view.h>
 
 #include "action_status.h"
@@ -40,8 +43,22 @@ namespace daw::glean {
 			return action_status::success;
 		}
 
-		constexpr action_status install( daw::glean::build_types ) const {
+		constexpr action_status install( daw::glean::build_types,
+		                                 glean_file_item const & ) const {
 			return action_status::success;
 		}
+
+		std::vector<std::string> build_inputs( daw::glean::build_types,
+		                                       glean_file_item const & ) const {
+			return {};
+		}
+
+		constexpr bool is_installed( daw::glean::build_types ) const {
+			return true;
+		}
+
+		fs::path install_manifest( daw::glean::build_types ) const {
+			return {};
+		}
 	};
 } // namespace daw::glean
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <daw/daw_enable_if.h>
 #include <daw/daw_traits.h>
 #include <daw/daw_visit.h>
@@ -29,6 +32,7 @@
 
 #include "action_status.h"
 #include "build_cmake.h"
+#include "build_header_only.h"
 #include "build_none.h"
 #include "glean_options.h"
 #include "impl/build_types_impl.h"
@@ -91,17 +95,56 @@ namespace daw::glean {
 			  m_value, [&]( auto const &v ) { return v.build( bt, file_dep ); } );
 		}
 
-		static_assert( ( daw::glean::impl::has_install_method_v<
+		static_assert(
+		  ( daw::glean::impl::has_install_method_v<
+		      BuildTypes, daw::glean::build_types, glean_file_item const &> and
+		    ... ),
+		  "All install types must support install method" );
+		[[nodiscard]] constexpr action_status
+		install( daw::glean::build_types bt,
+		         glean_file_item const &file_dep ) const {
+
+			return daw::visit_nt(
+			  m_value, [&]( auto const &v ) { return v.install( bt, file_dep ); } );
+		}
+
+		static_assert(
+		  ( daw::glean::impl::has_build_inputs_method_v<
+		      BuildTypes, daw::glean::build_types, glean_file_item const &> and
+		    ... ),
+		  "All build types must support build_inputs method" );
+		[[nodiscard]] std::vector<std::string>
+		build_inputs( daw::glean::build_types bt,
+		              glean_file_item const &file_dep ) const {
+
+			return daw::visit_nt( m_value, [&]( auto const &v ) {
+				return v.build_inputs( bt, file_dep );
+			} );
+		}
+
+		static_assert( ( daw::glean::impl::has_is_installed_method_v<
 		                   BuildTypes, daw::glean::build_types> and
 		                 ... ),
-		               "All install types must support install method" );
-		[[nodiscard]] constexpr action_status
-		install( daw::glean::build_types bt ) const {
+		               "All build types must support is_installed method" );
+		[[nodiscard]] bool is_installed( daw::glean::build_types bt ) const {
+
+			return daw::visit_nt(
+			  m_value, [bt]( auto const &v ) { return v.is_installed( bt ); } );
+		}
+
+		static_assert( ( daw::glean::impl::has_install_manifest_method_v<
+		                   BuildTypes, daw::glean::build_types> and
+		                 ... ),
+		               "All build types must support install_manifest method" );
+		[[nodiscard]] fs::path
+		install_manifest( daw::glean::build_types bt ) const {
 
-			return daw::visit_nt( m_value,
-			                      [bt]( auto const &v ) { return v.install( bt ); } );
+			return daw::visit_nt( m_value, [bt]( auto const &v ) {
+				return fs::path( v.install_manifest( bt ) );
+			} );
 		}
 	};
 
-	using build_types_t = basic_build_types<build_none, build_cmake>;
+	using build_types_t =
+	  basic_build_types<build_none, build_cmake, build_header_only>;
 } // namespace daw::glean
@@ -0,0 +1,63 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "action_status.h"
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief Record now as the last use of a cache entry or git mirror.  The
+	/// garbage collector evicts the least recently used first
+	void mark_cache_used( fs::path const &folder );
+
+	/// @brief Record how long the last build of a cache entry took.  Builds
+	/// that are slow to recreate are kept longer
+	/// @param build_name name of the build, such as its build type
+	void record_build_time( fs::path const &cache_folder,
+	                        std::string const &build_name,
+	                        std::chrono::seconds duration );
+
+	/// @brief Parse a size such as 500M or 20G, suffixes are powers of 1024
+	[[nodiscard]] std::optional<std::uintmax_t>
+	parse_size( std::string_view str );
+
+	/// @brief While the cache is larger than size_limit, evict build trees and
+	/// after them sources and the git mirrors no source uses.  The least
+	/// recently used and cheapest to recreate go first.  Anything another
+	/// glean has locked is left alone.  What is left of the old cache layout
+	/// counts towards the size but is only removed by migrate_cache
+	/// @param size_limit budget in bytes, without one nothing in use is evicted
+	[[nodiscard]] action_status
+	collect_cache_garbage( fs::path const &cache_root,
+	                       std::optional<std::uintmax_t> size_limit );
+
+	/// @brief Remove what is left of the cache layout of older versions of
+	/// glean, skipping anything another glean has locked
+	[[nodiscard]] action_status migrate_cache( fs::path const &cache_root );
+} // namespace daw::glean
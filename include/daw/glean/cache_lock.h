@@ -0,0 +1,70 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "utilities.h"
+
+namespace daw::glean {
+	enum class lock_modes { shared, exclusive };
+
+	/// @brief An advisory lock on a file in the cache, shared with other glean
+	/// processes.  Any number of shared holders or one exclusive holder.
+	/// Construction waits for the lock and destruction releases it
+	class cache_lock {
+#ifdef _WIN32
+		void *m_handle = nullptr;
+#else
+		int m_fd = -1;
+#endif
+		bool m_owns_lock = true;
+
+	public:
+		/// @param lock_file file to lock, it is created when missing
+		/// @param mode shared for readers of what the lock guards, exclusive for
+		/// writers
+		/// @param wait when false, give up instead of waiting for another holder
+		cache_lock( fs::path const &lock_file, lock_modes mode,
+		            bool wait = true );
+		~cache_lock( );
+
+		cache_lock( cache_lock const & ) = delete;
+		cache_lock( cache_lock && ) = delete;
+		cache_lock &operator=( cache_lock const & ) = delete;
+		cache_lock &operator=( cache_lock && ) = delete;
+
+		/// @brief False only when wait was false and another holder has it
+		[[nodiscard]] bool owns_lock( ) const noexcept;
+	};
+
+	/// @brief Held exclusively while downloading into a cache entry's source
+	/// and shared while reading or building it
+	[[nodiscard]] inline fs::path
+	source_lock_file( fs::path const &cache_folder ) {
+		return cache_folder / "source.lock";
+	}
+
+	/// @brief Held exclusively while a git mirror is changed
+	[[nodiscard]] inline fs::path mirror_lock_file( fs::path const &mirror ) {
+		return fs::path( mirror.string( ) + ".lock" );
+	}
+} // namespace daw::glean
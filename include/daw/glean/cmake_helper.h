@@ -38,7 +38,8 @@ namespace daw::glean {
 	template<typename CmakeAction, typename OutputIterator>
 	[[nodiscard]] action_status
 	cmake_runner( CmakeAction &&cmake_action, fs::path work_tree,
-	              daw::glean::build_types bt, OutputIterator &&out_it ) {
+	              daw::glean::build_types bt, process_options proc_opts,
+	              OutputIterator &&out_it ) {
 
 		auto args = cmake_action.build_args( std::move( work_tree ), bt );
 		log_message << "Running cmake";
@@ -47,16 +48,30 @@ namespace daw::glean {
 		}
 		log_message << "\n\n";
 
-		auto run_process = Process( std::forward<OutputIterator>( out_it ) );
+		auto run_process = Process( std::forward<OutputIterator>( out_it ),
+		                            std::move( proc_opts ) );
 		return to_action_status( run_process( "cmake", std::move( args ) ) ==
 		                         EXIT_SUCCESS );
 	}
 
+	/// @brief The folder of the build path that every build type shares in a
+	/// multi-config build
+	static inline constexpr char const multi_config_folder[] = "multi";
+
+	/// @brief The cmake configuration of a build type, such as Debug
+	[[nodiscard]] std::string cmake_config_name( daw::glean::build_types bt );
+
 	struct cmake_action_configure {
 		fs::path source_path;
 		fs::path install_prefix;
 		std::vector<std::string> custom_arguments;
 		bool has_glean;
+		// Run the C and C++ compilers through this, such as ccache, when set
+		fs::path compiler_launcher{};
+		// Configure one Ninja Multi-Config folder for all build types.  It is
+		// configured with the release prefix and each configuration is moved to
+		// its own by cmake_action_install_config
+		bool multi_config = false;
 
 		cmake_action_configure( fs::path source, fs::path install,
 		                        std::vector<std::string> custom,
@@ -68,14 +83,61 @@ namespace daw::glean {
 
 	struct cmake_action_build {
 		uint32_t jobs = 2;
+		// When the build tool joins glean's jobserver it takes its job slots
+		// from MAKEFLAGS, an explicit -j would make it ignore the jobserver
+		bool use_jobserver = false;
+		// Build the build type's configuration of the multi-config folder
+		bool multi_config = false;
 		constexpr cmake_action_build( ) noexcept = default;
 		constexpr cmake_action_build( uint32_t j ) noexcept
 		  : jobs( j ) {}
+		constexpr cmake_action_build( uint32_t j, bool jobserver ) noexcept
+		  : jobs( j )
+		  , use_jobserver( jobserver ) {}
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path build_path, daw::glean::build_types bt ) const;
 	};
 
 	struct cmake_action_install {
+		// Jobs to build whatever install still needs with, none when it has
+		// already been built
+		uint32_t jobs = 0;
+		bool use_jobserver = false;
+		constexpr cmake_action_install( ) noexcept = default;
+		constexpr cmake_action_install( uint32_t j, bool jobserver ) noexcept
+		  : jobs( j )
+		  , use_jobserver( jobserver ) {}
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path build_path, daw::glean::build_types bt ) const;
+	};
+
+	/// @brief Install the build type's configuration of the multi-config
+	/// folder into its own folder of install_prefix, without building
+	struct cmake_action_install_config {
+		fs::path install_prefix;
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path build_path, daw::glean::build_types bt ) const;
+	};
+
+	/// @brief Pack the files named in file_list, relative to the folder cmake
+	/// runs in, into a gzip compressed archive
+	struct cmake_action_tar_create {
+		fs::path archive;
+		fs::path file_list;
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path build_path, daw::glean::build_types bt ) const;
+	};
+
+	/// @brief Unpack archive into the folder cmake runs in
+	struct cmake_action_tar_extract {
+		fs::path archive;
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path build_path, daw::glean::build_types bt ) const;
+	};
+
+	/// @brief Write the paths in archive to stdout, one per line
+	struct cmake_action_tar_list {
+		fs::path archive;
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path build_path, daw::glean::build_types bt ) const;
 	};
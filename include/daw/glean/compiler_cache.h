@@ -0,0 +1,83 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glean_config.h"
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief A compiler cache, such as ccache or sccache, that cmake runs every
+	/// compiler of a dependency build through.  ccache and sccache keep their
+	/// files in a folder of the glean cache with its own size limit
+	class compiler_cache {
+		fs::path m_launcher{};
+		fs::path m_folder{};
+		std::string m_size_limit{};
+		fs::path m_base_dir{};
+		// The counters when the run started, the cache is shared with other
+		// glean processes and builds so they are never zeroed
+		std::map<std::string, std::int64_t> m_start_statistics{};
+
+		[[nodiscard]] std::map<std::string, std::int64_t> statistics( ) const;
+
+	public:
+		/// @param launcher the program cmake runs the compilers with
+		/// @param cache_root the glean cache
+		/// @param size_limit bytes the launcher may keep, see parse_size
+		compiler_cache( fs::path launcher, fs::path const &cache_root,
+		                std::uintmax_t size_limit );
+
+		[[nodiscard]] fs::path const &launcher( ) const noexcept;
+
+		/// @brief Have paths below base_dir hashed relative to the build folder,
+		/// so that builds of the same sources elsewhere share entries.  Only
+		/// ccache supports this
+		void set_base_dir( fs::path base_dir );
+
+		/// @brief Variables that point the launcher at its folder, to add to the
+		/// environment of every build
+		[[nodiscard]] std::vector<std::pair<std::string, std::string>>
+		environment( ) const;
+
+		/// @brief Remember the hits and misses so far, log_statistics shows the
+		/// change since
+		void snapshot_statistics( );
+
+		/// @brief Show how the hits and misses changed since
+		/// snapshot_statistics.  Builds that share the cache at the same time
+		/// are counted too
+		void log_statistics( ) const;
+	};
+
+	/// @brief The compiler_launcher of the config, or ccache or sccache when
+	/// found on the PATH.  None when the config says "none" or nothing is found
+	[[nodiscard]] std::optional<compiler_cache>
+	find_compiler_cache( glean_config const &config, fs::path const &cache_root );
+} // namespace daw::glean
@@ -57,7 +57,18 @@ namespace daw::glean {
 
 		[[nodiscard]] std::string const &name( ) const noexcept;
 		[[nodiscard]] action_status build( daw::glean::build_types bt ) const;
-		[[nodiscard]] action_status install( daw::glean::build_types bt ) const;
+		/// @param dependency_packages the packages of the nodes this one depends
+		/// on
+		[[nodiscard]] action_status
+		install( daw::glean::build_types bt,
+		         std::vector<cmake_package_t> dependency_packages ) const;
+		[[nodiscard]] std::vector<std::string>
+		build_inputs( daw::glean::build_types bt ) const;
+		[[nodiscard]] bool is_installed( daw::glean::build_types bt ) const;
+		/// @brief Where the build type lists what it installed, empty when it
+		/// installs nothing
+		[[nodiscard]] fs::path
+		install_manifest( daw::glean::build_types bt ) const;
 		[[nodiscard]] glean_file_item const &file_dep( ) const noexcept;
 		[[nodiscard]] bool has_file_dep( ) const noexcept;
 		[[nodiscard]] std::vector<item_t> &alternatives( ) noexcept;
@@ -0,0 +1,60 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief Incremental SHA-256.  Used wherever glean needs a stable digest
+	/// that can be stored on disk and compared between runs
+	class sha256 {
+		std::array<uint32_t, 8> m_state;
+		std::array<unsigned char, 64> m_block{};
+		size_t m_block_size = 0;
+		uint64_t m_total_size = 0;
+
+		void process_block( );
+
+	public:
+		sha256( ) noexcept;
+
+		sha256 &update( std::string_view data );
+
+		/// @brief Add a field followed by a separator, so that adjacent fields
+		/// cannot run together
+		sha256 &update_field( std::string_view data );
+
+		/// @brief The lowercase hex digest.  The object must not be updated after
+		[[nodiscard]] std::string hex_digest( );
+	};
+
+	[[nodiscard]] std::string sha256_hex( std::string_view data );
+
+	/// @brief The sha256_hex of a file's content, empty when it cannot be read
+	[[nodiscard]] std::string sha256_file_hex( fs::path const &file );
+} // namespace daw::glean
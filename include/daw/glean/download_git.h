@@ -22,15 +22,25 @@
 
 #pragma once
 
+#include <string>
+
 #include "action_status.h"
 #include "glean_file_item.h"
+#include "glean_options.h"
 #include "utilities.h"
 
 namespace daw::glean {
 	struct download_git {
 		constexpr static daw::string_view type_id = "git";
 
+		/// @brief Fetch dep.uri into its mirror under the cache root, when the
+		/// clone strategy allows, and check out dep.version in cache_folder
 		[[nodiscard]] action_status download( glean_file_item const &dep,
-		                                      fs::path const &repos ) const;
+		                                      fs::path const &cache_folder,
+		                                      glean_options const &opts ) const;
+
+		/// @brief The commit checked out in the cache folder, empty if unknown
+		[[nodiscard]] std::string
+		source_revision( fs::path const &cache_folder ) const;
 	};
 } // namespace daw::glean
@@ -22,8 +22,11 @@
 
 #pragma once
 
+#include <string>
+
 #include "action_status.h"
 #include "glean_file_item.h"
+#include "glean_options.h"
 #include "utilities.h"
 
 namespace daw::glean {
@@ -31,8 +34,14 @@ namespace daw::glean {
 		constexpr static daw::string_view type_id = "none";
 
 		constexpr action_status download( glean_file_item const &,
-		                                  fs::path const & ) const {
+		                                  fs::path const &,
+		                                  glean_options const & ) const {
 			return action_status::success;
 		}
+
+		// Nothing is downloaded, so nothing can change
+		[[nodiscard]] std::string source_revision( fs::path const & ) const {
+			return std::string( type_id );
+		}
 	};
 } // namespace daw::glean
@@ -22,8 +22,11 @@
 
 #pragma once
 
+#include <string>
+
 #include "action_status.h"
 #include "glean_file_item.h"
+#include "glean_options.h"
 #include "utilities.h"
 
 namespace daw::glean {
@@ -31,6 +34,11 @@ namespace daw::glean {
 		constexpr static daw::string_view type_id = "svn";
 
 		[[nodiscard]] action_status download( glean_file_item const &dep,
-		                                      fs::path const &source_folder ) const;
+		                                      fs::path const &source_folder,
+		                                      glean_options const &opts ) const;
+
+		/// @brief The revision checked out in the cache folder, empty if unknown
+		[[nodiscard]] std::string
+		source_revision( fs::path const &cache_folder ) const;
 	};
 } // namespace daw::glean
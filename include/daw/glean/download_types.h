@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <string>
 #include <utility>
 #include <variant>
 
@@ -31,6 +32,7 @@
 #include <daw/daw_visit.h>
 
 #include "action_status.h"
+#include "glean_options.h"
 #include "download_git.h"
 #include "download_none.h"
 #include "download_svn.h"
@@ -70,9 +72,18 @@ namespace daw::glean {
 		  : m_value( construct_dt<DownloadTypes...>( type ) ) {}
 
 		inline action_status download( glean_file_item const &dep,
-		                               fs::path const &cache_folder ) const {
+		                               fs::path const &cache_folder,
+		                               glean_options const &opts ) const {
 			return daw::visit_nt( m_value, [&]( auto const &v ) {
-				return v.download( dep, cache_folder );
+				return v.download( dep, cache_folder, opts );
+			} );
+		}
+
+		/// @brief Identifies the source that was downloaded into cache_folder,
+		/// empty when it cannot be determined
+		inline std::string source_revision( fs::path const &cache_folder ) const {
+			return daw::visit_nt( m_value, [&]( auto const &v ) {
+				return v.source_revision( cache_folder );
 			} );
 		}
 
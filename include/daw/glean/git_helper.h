@@ -28,15 +28,16 @@
 #include <daw/daw_utility.h>
 
 #include "action_status.h"
+#include "glean_options.h"
 #include "logging.h"
 #include "proc.h"
 #include "utilities.h"
 
 namespace daw::glean {
 	template<typename GitAction, typename OutputIterator>
-	[[nodiscard]] action_status git_runner( GitAction &&git_action,
-	                                        fs::path work_tree,
-	                                        OutputIterator &&out_it ) {
+	[[nodiscard]] action_status
+	git_runner( GitAction &&git_action, fs::path work_tree,
+	            process_options proc_opts, OutputIterator &&out_it ) {
 		auto args = git_action.build_args( std::move( work_tree ) );
 		log_message << "Running git";
 		for( auto arg : args ) {
@@ -44,30 +45,104 @@ namespace daw::glean {
 		}
 		log_message << "\n\n";
 
-		auto run_process = Process( std::forward<OutputIterator>( out_it ) );
+		auto run_process = Process( std::forward<OutputIterator>( out_it ),
+		                            std::move( proc_opts ) );
 		return to_action_status( run_process( "git", std::move( args ) ) ==
 		                         EXIT_SUCCESS );
 	}
 
 	struct git_action_version {
 		std::string version{};
+		// Check out the commit of version, never the branch itself
+		bool detach = false;
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	struct git_action_rev_parse {
+		std::string rev = "HEAD";
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Lists the refs on origin that match name
+	struct git_action_ls_remote {
+		std::string remote = "origin";
+		std::string name{};
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Add branch to the ones fetched from origin, so that a clone limited to
+	// one branch can check it out by name
+	struct git_action_track_branch {
+		std::string branch{};
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	struct git_action_config {
+		std::string name{};
+		std::string value{};
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	struct git_action_fetch {
+		std::vector<std::string> refspecs{};
+		// Keep a shallow repository at depth 1 instead of fetching history
+		bool is_shallow = false;
+		// Fetch all of the history that a shallow clone left out
+		bool unshallow = false;
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Every local ref and HEAD, with tags also peeled to their commit
+	struct git_action_show_ref {
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Lists modified tracked files, nothing when the tree is clean
+	struct git_action_status {
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path const &work_tree ) const;
 	};
 
 	struct git_action_reset {
+		// Commit to move the current branch to, HEAD when empty
+		std::string target{};
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Adds work_tree as a detached working tree of the repository git is run
+	// in.  The checkout is left to git_action_version
+	struct git_action_worktree_add {
+		[[nodiscard]] std::vector<std::string>
+		build_args( fs::path const &work_tree ) const;
+	};
+
+	// Forgets working trees whose folders were removed
+	struct git_action_worktree_prune {
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path const &work_tree ) const;
 	};
 
-	struct git_action_pull {
+	struct git_action_submodule_update {
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path const &work_tree ) const;
 	};
 
 	struct git_action_clone {
 		std::string remote_uri{};
+		// Branch or tag to clone, the remote's default when empty
+		std::string branch{};
+		clone_strategies strategy = clone_strategies::full;
 		bool recurse_submodules = true;
+		// A bare copy of every ref, used as a local mirror of the remote
+		bool is_mirror = false;
 
 		[[nodiscard]] std::vector<std::string>
 		build_args( fs::path const &work_tree ) const;
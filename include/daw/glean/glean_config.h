@@ -35,6 +35,14 @@ namespace daw::glean {
 	struct glean_config {
 		fs::path cache_folder = fs::path( get_home( ) ) / ".glean_cache";
 		fs::path cmake_binary = "cmake";
+		// Size budget of the cache, such as 50G.  When set the cache is garbage
+		// collected after every run
+		std::string cache_size_limit{};
+		// Program, such as ccache or sccache, that cmake runs compilers through.
+		// Found on the PATH when empty, none when "none"
+		std::string compiler_launcher{};
+		// Size budget of ccache or sccache's folder in the cache, 5G when empty
+		std::string compiler_cache_size_limit{};
 	}; // glean_config
 
 	glean_config get_config( );
@@ -49,18 +57,40 @@ namespace daw::glean {
 template<>
 struct daw::json::json_data_contract<daw::glean::glean_config> {
 #ifdef __cpp_nontype_template_parameter_class
-	using type = json_member_list<json_string<"glean_config_cache_folder">,
-	                              json_string<"glean_config_cmake_binary">>;
+	using type = json_member_list<
+	  json_string<"glean_config_cache_folder">,
+	  json_string<"glean_config_cmake_binary">,
+	  json_string_null<"cache_size_limit", std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<"compiler_launcher", std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<"compiler_cache_size_limit", std::string,
+	                   daw::construct_a_t<std::string>>>;
 #else
 	static inline constexpr char const glean_config_cache_folder[] =
 	  "cache_folder";
 	static inline constexpr char const glean_config_cmake_binary[] =
 	  "cmake_binary";
-	using type = json_member_list<json_string<glean_config_cache_folder>,
-	                              json_string<glean_config_cmake_binary>>;
+	static inline constexpr char const glean_config_cache_size_limit[] =
+	  "cache_size_limit";
+	static inline constexpr char const glean_config_compiler_launcher[] =
+	  "compiler_launcher";
+	static inline constexpr char const
+	  glean_config_compiler_cache_size_limit[] = "compiler_cache_size_limit";
+	using type = json_member_list<
+	  json_string<glean_config_cache_folder>,
+	  json_string<glean_config_cmake_binary>,
+	  json_string_null<glean_config_cache_size_limit, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<glean_config_compiler_launcher, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<glean_config_compiler_cache_size_limit, std::string,
+	                   daw::construct_a_t<std::string>>>;
 #endif
 	static inline auto to_json_data( daw::glean::glean_config const &gc ) {
 		return std::make_tuple( gc.cache_folder.string( ),
-		                        gc.cmake_binary.string( ) );
+		                        gc.cmake_binary.string( ), gc.cache_size_limit,
+		                        gc.compiler_launcher,
+		                        gc.compiler_cache_size_limit );
 	}
 };
@@ -25,6 +25,7 @@
 #include <daw/daw_graph.h>
 
 #include "dependency.h"
+#include "glean_lock.h"
 #include "glean_options.h"
 #include "utilities.h"
 
@@ -33,8 +34,22 @@ namespace daw::glean {
 	process_config_file( fs::path const &config_file_path,
 	                     glean_options const &opts );
 
-	void process_deps( daw::graph_t<dependency> const &known_deps,
-	                   glean_options const &opts );
+	/// @brief Build the graph recorded in a lock file.  Every dependency is
+	/// downloaded up front, at its locked revision, and no glean.json is read
+	[[nodiscard]] action_status
+	process_lock_file( fs::path const &lock_file_path,
+	                   glean_options const &opts,
+	                   daw::graph_t<dependency> &known_deps );
+
+	/// @brief Record the resolved graph with the revision each node is at.
+	/// Fails when the revision of a git dependency cannot be found
+	[[nodiscard]] action_status
+	make_lock_file( daw::graph_t<dependency> const &known_deps,
+	                glean_options const &opts, glean_lock_file &lock );
+
+	[[nodiscard]] action_status
+	process_deps( daw::graph_t<dependency> const &known_deps,
+	              glean_options const &opts );
 
 	void cmake_deps( daw::graph_t<dependency> const &known_deps );
 } // namespace daw::glean
@@ -27,9 +27,17 @@
 
 #include <daw/json/daw_json_link.h>
 
+#include "digest.h"
 #include "utilities.h"
 
 namespace daw::glean {
+	/// @brief A cmake package that a dependency installs and the target
+	/// find_package of it provides
+	struct cmake_package_t {
+		std::string name{};
+		std::string target{};
+	};
+
 	// Data structure to represent the dependencies
 	struct glean_file_item {
 		std::string provides{};
@@ -40,14 +48,38 @@ namespace daw::glean {
 		std::string custom_options{};
 		std::vector<std::string> cmake_args{};
 		bool is_optional = false;
+		// Empty uses the global clone strategy.  How much history is fetched does
+		// not change what is built, so it is not part of an item's identity
+		std::string clone_strategy{};
+		// Exact revision to check out instead of version, set from glean.lock.
+		// It is not part of the cache key, so a locked build shares the build
+		// tree of the version it was resolved from
+		std::string revision{};
+		// The cmake package and target the dependency installs, when they are
+		// not named after provides
+		std::string package_name{};
+		std::string target{};
+		// The packages of the nodes this one depends on whose names are known.
+		// Set from the graph when it is installed, it is not read from
+		// glean.json
+		std::vector<cmake_package_t> dependency_packages{};
 
 	private:
 		inline decltype( auto ) to_tuple( ) const noexcept {
 			return std::tie( provides, download_type, build_type, uri, version,
-			                 custom_options, cmake_args, is_optional );
+			                 custom_options, cmake_args, is_optional, package_name,
+			                 target );
 		}
 
 	public:
+		/// @brief package_name and target, or <provides> and
+		/// <provides>::<provides> when not given
+		[[nodiscard]] inline cmake_package_t cmake_package( ) const {
+			auto name = package_name.empty( ) ? provides : package_name;
+			auto tgt = target.empty( ) ? name + "::" + name : target;
+			return {std::move( name ), std::move( tgt )};
+		}
+
 		inline friend bool operator==( glean_file_item const &lhs,
 		                               glean_file_item const &rhs ) noexcept {
 			return lhs.to_tuple( ) == rhs.to_tuple( );
@@ -58,9 +90,36 @@ namespace daw::glean {
 			return lhs.to_tuple( ) != rhs.to_tuple( );
 		}
 
-		inline fs::path cache_folder( fs::path const &cache_base_folder ) const {
-			auto uri_hash = std::to_string( std::hash<std::string>{}( uri ) );
-			return cache_base_folder / uri_hash;
+		/// @brief Identifies this item's source and build in the cache.  Items
+		/// that differ in anything that changes what is built get their own
+		/// key, so several versions can coexist and keep warm build trees
+		[[nodiscard]] inline std::string
+		cache_key( std::vector<std::string> const &global_cmake_args ) const {
+			auto digest = sha256( );
+			digest.update_field( "glean cache key 1" )
+			  .update_field( download_type )
+			  .update_field( normalize_uri( uri ) )
+			  .update_field( version )
+			  .update_field( build_type )
+			  .update_field( custom_options )
+			  .update_field( std::to_string( global_cmake_args.size( ) ) );
+			for( auto const &arg : global_cmake_args ) {
+				digest.update_field( arg );
+			}
+			for( auto const &arg : cmake_args ) {
+				digest.update_field( arg );
+			}
+			// Only when given, so the keys of other items stay as they were
+			if( not package_name.empty( ) or not target.empty( ) ) {
+				digest.update_field( package_name ).update_field( target );
+			}
+			return digest.hex_digest( ).substr( 0, 32 );
+		}
+
+		[[nodiscard]] inline fs::path
+		cache_folder( fs::path const &cache_root,
+		              std::vector<std::string> const &global_cmake_args ) const {
+			return cache_root / provides / cache_key( global_cmake_args );
 		}
 	};
 
@@ -81,7 +140,13 @@ struct daw::json::json_data_contract<daw::glean::glean_file_item> {
 	  json_string_null<"custom_options", std::string,
 	                   daw::construct_a_t<std::string>>,
 	  json_array_null<"cmake_args", std::string>,
-	  json_bool_null<"is_optional", bool>>;
+	  json_bool_null<"is_optional", bool>,
+	  json_string_null<"clone_strategy", std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<"package_name", std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<"target", std::string,
+	                   daw::construct_a_t<std::string>>>;
 #else
 	static inline constexpr char const provides[] = "provides";
 	static inline constexpr char const download_type[] = "download_type";
@@ -91,6 +156,9 @@ struct daw::json::json_data_contract<daw::glean::glean_file_item> {
 	static inline constexpr char const custom_options[] = "custom_options";
 	static inline constexpr char const cmake_args[] = "cmake_args";
 	static inline constexpr char const is_optional[] = "is_optional";
+	static inline constexpr char const clone_strategy[] = "clone_strategy";
+	static inline constexpr char const package_name[] = "package_name";
+	static inline constexpr char const target[] = "target";
 
 	using type = json_member_list<
 	  json_string<provides>, json_string<download_type>, json_string<build_type>,
@@ -99,7 +167,12 @@ struct daw::json::json_data_contract<daw::glean::glean_file_item> {
 	  json_string_null<custom_options, std::string,
 	                   daw::construct_a_t<std::string>>,
 	  json_array_null<cmake_args, std::string>,
-	  json_bool_null<is_optional, bool>>;
+	  json_bool_null<is_optional, bool>,
+	  json_string_null<clone_strategy, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<package_name, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<target, std::string, daw::construct_a_t<std::string>>>;
 #endif
 };
 template<>
@@ -117,12 +190,3 @@ struct daw::json::json_data_contract<daw::glean::glean_config_file> {
 	                   json_array<dependencies, daw::glean::glean_file_item>>;
 #endif
 };
-
-namespace std {
-	template<>
-	struct hash<daw::glean::glean_file_item> {
-		inline size_t operator( )( daw::glean::glean_file_item const &g ) const {
-			return std::hash<std::string>{}( g.provides + g.download_type );
-		}
-	};
-} // namespace std
@@ -0,0 +1,156 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <daw/json/daw_json_link.h>
+
+#include "action_status.h"
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief One resolved node of the dependency graph
+	struct glean_lock_item {
+		std::string provides{};
+		std::string download_type{};
+		std::string build_type{};
+		std::string uri{};
+		// The version glean.json asked for
+		std::string version{};
+		// The exact revision that was checked out, for git the commit hash
+		std::string revision{};
+		// cmake_args after the dependency options file was applied
+		std::vector<std::string> cmake_args{};
+		std::string custom_options{};
+		std::string clone_strategy{};
+		std::string package_name{};
+		std::string target{};
+		// The provides names of the nodes this one depends on
+		std::vector<std::string> depends{};
+		bool is_optional = false;
+	};
+
+	/// @brief The whole resolved dependency graph, written to glean.lock so
+	/// that a --locked run can build it without resolving anything
+	struct glean_lock_file {
+		std::string provides{};
+		std::vector<std::string> depends{};
+		// toolchain_id of the build that wrote it, compared by --locked builds
+		std::string toolchain{};
+		std::vector<glean_lock_item> dependencies{};
+	};
+
+	[[nodiscard]] action_status read_lock_file( fs::path const &lock_file_path,
+	                                            glean_lock_file &lock );
+
+	/// @brief Write the lock file, unless it already holds the same graph
+	[[nodiscard]] action_status write_lock_file( fs::path const &lock_file_path,
+	                                             glean_lock_file const &lock );
+} // namespace daw::glean
+
+template<>
+struct daw::json::json_data_contract<daw::glean::glean_lock_item> {
+#ifdef __cpp_nontype_template_parameter_class
+	using type =
+	  json_member_list<json_string<"provides">, json_string<"download_type">,
+	                   json_string<"build_type">, json_string<"uri">,
+	                   json_string_null<"version", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_string_null<"revision", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_array_null<"cmake_args", std::string>,
+	                   json_string_null<"custom_options", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_string_null<"clone_strategy", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_string_null<"package_name", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_string_null<"target", std::string,
+	                                    daw::construct_a_t<std::string>>,
+	                   json_array_null<"depends", std::string>,
+	                   json_bool_null<"is_optional", bool>>;
+#else
+	static inline constexpr char const provides[] = "provides";
+	static inline constexpr char const download_type[] = "download_type";
+	static inline constexpr char const build_type[] = "build_type";
+	static inline constexpr char const uri[] = "uri";
+	static inline constexpr char const version[] = "version";
+	static inline constexpr char const revision[] = "revision";
+	static inline constexpr char const cmake_args[] = "cmake_args";
+	static inline constexpr char const custom_options[] = "custom_options";
+	static inline constexpr char const clone_strategy[] = "clone_strategy";
+	static inline constexpr char const package_name[] = "package_name";
+	static inline constexpr char const target[] = "target";
+	static inline constexpr char const depends[] = "depends";
+	static inline constexpr char const is_optional[] = "is_optional";
+	using type = json_member_list<
+	  json_string<provides>, json_string<download_type>, json_string<build_type>,
+	  json_string<uri>,
+	  json_string_null<version, std::string, daw::construct_a_t<std::string>>,
+	  json_string_null<revision, std::string, daw::construct_a_t<std::string>>,
+	  json_array_null<cmake_args, std::string>,
+	  json_string_null<custom_options, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<clone_strategy, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<package_name, std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_string_null<target, std::string, daw::construct_a_t<std::string>>,
+	  json_array_null<depends, std::string>, json_bool_null<is_optional, bool>>;
+#endif
+	static inline auto to_json_data( daw::glean::glean_lock_item const &item ) {
+		return std::forward_as_tuple( item.provides, item.download_type,
+		                              item.build_type, item.uri, item.version,
+		                              item.revision, item.cmake_args,
+		                              item.custom_options, item.clone_strategy,
+		                              item.package_name, item.target,
+		                              item.depends, item.is_optional );
+	}
+};
+
+template<>
+struct daw::json::json_data_contract<daw::glean::glean_lock_file> {
+#ifdef __cpp_nontype_template_parameter_class
+	using type = json_member_list<
+	  json_string<"provides">, json_array_null<"depends", std::string>,
+	  json_string_null<"toolchain", std::string,
+	                   daw::construct_a_t<std::string>>,
+	  json_array<"dependencies", daw::glean::glean_lock_item>>;
+#else
+	static inline constexpr char const provides[] = "provides";
+	static inline constexpr char const depends[] = "depends";
+	static inline constexpr char const toolchain[] = "toolchain";
+	static inline constexpr char const dependencies[] = "dependencies";
+	using type = json_member_list<
+	  json_string<provides>, json_array_null<depends, std::string>,
+	  json_string_null<toolchain, std::string, daw::construct_a_t<std::string>>,
+	  json_array<dependencies, daw::glean::glean_lock_item>>;
+#endif
+	static inline auto to_json_data( daw::glean::glean_lock_file const &lock ) {
+		return std::forward_as_tuple( lock.provides, lock.depends, lock.toolchain,
+		                              lock.dependencies );
+	}
+};
@@ -24,7 +24,10 @@
 
 #include <boost/program_options/variables_map.hpp>
 #include <iosfwd>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "dependency_options.h"
@@ -41,15 +44,76 @@ namespace daw::glean {
 	std::istream &operator>>( std::istream &is, output_types &bt );
 	std::string to_string( output_types bt );
 
+	/// @brief How much of a git repository's history is cloned.
+	///   full          - everything
+	///   shallow       - only the requested version, depth 1
+	///   blobless      - all commits, file contents fetched on checkout
+	///   single_branch - the history of the requested version only
+	enum class clone_strategies : uint8_t {
+		full,
+		shallow,
+		blobless,
+		single_branch
+	};
+	std::ostream &operator<<( std::ostream &os, clone_strategies cs );
+	std::istream &operator>>( std::istream &is, clone_strategies &cs );
+	std::string to_string( clone_strategies cs );
+	[[nodiscard]] std::optional<clone_strategies>
+	clone_strategy_from_string( std::string_view str );
+
+	/// @brief How much of each dependency is built.
+	///   full    - everything its build does by default
+	///   minimal - no tests, examples, benchmarks or docs, and only what the
+	///             install target needs
+	enum class build_profiles : uint8_t { full, minimal };
+	std::ostream &operator<<( std::ostream &os, build_profiles bp );
+	std::istream &operator>>( std::istream &is, build_profiles &bp );
+	std::string to_string( build_profiles bp );
+
 	struct glean_options {
 		daw::glean::fs::path install_prefix{};
 		daw::glean::fs::path glean_cache{};
+		// Where installed outputs are stored and restored from, none when empty
+		daw::glean::fs::path artifact_cache{};
+		// An http:// server, from glean serve-cache, that artifacts are fetched
+		// from and uploaded to
+		std::string artifact_server{};
+		// Address and port serve-cache listens on
+		std::string listen{};
 		daw::glean::build_types build_type{};
 		daw::glean::output_types output_type{};
+		// Used for items that do not specify a clone_strategy
+		daw::glean::clone_strategies clone_strategy{};
+		daw::glean::build_profiles build_profile{};
 		std::vector<std::string> cmake_args{};
+		// Environment added to every build tool invocation
+		std::vector<std::pair<std::string, std::string>> build_environment{};
+		// Compiler cache that cmake builds run the compilers through, none when
+		// empty
+		daw::glean::fs::path compiler_launcher{};
+		// Keep the paths of this machine out of what dependency builds produce,
+		// so that their compiler cache entries and artifacts can be shared
+		bool relocatable = false;
+		// Configure each dependency once with Ninja Multi-Config and build and
+		// install every build type from that folder
+		bool multi_config = false;
 		uint32_t jobs = 2U;
+		uint32_t fetch_jobs = 4U;
+		uint32_t build_jobs = 1U;
+		// Concurrent downloads and uploads of the artifact server
+		uint32_t transfer_jobs = 4U;
 		dependency_options dep_opts{};
 		bool use_first = false;
+		bool use_jobserver = true;
+		// Whether ninja takes its job slots from the jobserver, make always does
+		bool ninja_joins_jobserver = false;
+		bool verbose = false;
+		// Build the graph in glean.lock instead of resolving glean.json
+		bool locked = false;
+		// Positional arguments, such as cache gc
+		std::vector<std::string> command{};
+		// Overrides the cache_size_limit of the glean config
+		std::string cache_size_limit{};
 
 		glean_options( int argc, char **argv );
 	};
@@ -0,0 +1,172 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <daw/daw_graph.h>
+
+#include "action_status.h"
+#include "logging.h"
+#include "task_pool.h"
+
+namespace daw::glean {
+	/// @brief Runs a task for each node of a graph once the tasks of every node
+	/// it depends on, its outgoing edges, have succeeded.  Each config is an
+	/// independent copy of the graph and all of them share one pool of
+	/// workers.  A task that fails or throws cancels only the nodes that depend
+	/// on it
+	template<typename T>
+	class graph_scheduler {
+	public:
+		using task_t =
+		  std::function<action_status( size_t config, daw::node_id_t id )>;
+		using name_t =
+		  std::function<std::string( size_t config, daw::node_id_t id )>;
+
+	private:
+		struct node_state_t {
+			size_t pending_deps = 0;
+			bool is_cancelled = false;
+			bool is_done = false;
+		};
+
+		daw::graph_t<T> const *m_graph;
+		task_t m_task;
+		name_t m_name;
+		std::mutex m_mutex{};
+		std::vector<std::unordered_map<daw::node_id_t, node_state_t>> m_states;
+		std::vector<std::string> m_failed{};
+		std::vector<std::string> m_cancelled{};
+		task_pool m_pool;
+
+		// A task that throws has failed like one that returns failure
+		[[nodiscard]] action_status run_task( size_t config,
+		                                      daw::node_id_t id ) {
+			try {
+				return m_task( config, id );
+			} catch( std::exception const &ex ) {
+				log_error << "Error in " << m_name( config, id ) << ": " << ex.what( )
+				          << '\n';
+			} catch( ... ) {
+				log_error << "Unknown error in " << m_name( config, id ) << '\n';
+			}
+			return action_status::failure;
+		}
+
+		// Must be called with m_mutex held
+		void cancel_dependents( size_t config, daw::node_id_t id ) {
+			for( auto dependent_id : m_graph->get_raw_node( id ).incoming_edges( ) ) {
+				auto &state = m_states[config][dependent_id];
+				if( state.is_cancelled ) {
+					continue;
+				}
+				state.is_cancelled = true;
+				m_cancelled.push_back( m_name( config, dependent_id ) );
+				cancel_dependents( config, dependent_id );
+			}
+		}
+
+		// Must be called with m_mutex held
+		void schedule( size_t config, daw::node_id_t id ) {
+			m_pool.add_task( [this, config, id]( ) {
+				auto const result = run_task( config, id );
+
+				auto const lck = std::lock_guard<std::mutex>( m_mutex );
+				if( not to_bool( result ) ) {
+					m_failed.push_back( m_name( config, id ) );
+					cancel_dependents( config, id );
+					return;
+				}
+				m_states[config][id].is_done = true;
+				for( auto dependent_id :
+				     m_graph->get_raw_node( id ).incoming_edges( ) ) {
+					auto &state = m_states[config][dependent_id];
+					if( --state.pending_deps == 0 and not state.is_cancelled ) {
+						schedule( config, dependent_id );
+					}
+				}
+			} );
+		}
+
+	public:
+		graph_scheduler( daw::graph_t<T> const &graph, size_t config_count,
+		                 uint32_t jobs, task_t task, name_t name )
+		  : m_graph( &graph )
+		  , m_task( std::move( task ) )
+		  , m_name( std::move( name ) )
+		  , m_states( config_count )
+		  , m_pool( jobs ) {}
+
+		/// @brief Run every task and report the nodes that failed or were not
+		/// run.  Nodes in a dependency cycle, or depending on one, are never
+		/// ready and fail the run
+		[[nodiscard]] action_status run( ) {
+			{
+				auto const lck = std::lock_guard<std::mutex>( m_mutex );
+				for( auto &states : m_states ) {
+					m_graph->visit( [&]( auto const &node ) {
+						states[node.id( )].pending_deps = node.outgoing_edges( ).size( );
+					} );
+				}
+				for( size_t config = 0; config < m_states.size( ); ++config ) {
+					for( auto const &state : m_states[config] ) {
+						if( state.second.pending_deps == 0 ) {
+							schedule( config, state.first );
+						}
+					}
+				}
+			}
+			m_pool.wait( );
+
+			auto const lck = std::lock_guard<std::mutex>( m_mutex );
+			auto not_run = std::vector<std::string>( );
+			for( size_t config = 0; config < m_states.size( ); ++config ) {
+				for( auto const &state : m_states[config] ) {
+					if( not state.second.is_done and not state.second.is_cancelled and
+					    state.second.pending_deps > 0 ) {
+						not_run.push_back( m_name( config, state.first ) );
+					}
+				}
+			}
+			for( auto const &name : m_failed ) {
+				log_error << "Failed: " << name << '\n';
+			}
+			for( auto const &name : m_cancelled ) {
+				log_error << "Skipped, a dependency failed: " << name << '\n';
+			}
+			for( auto const &name : not_run ) {
+				log_error << "Not built, it is in or depends on a dependency cycle: "
+				          << name << '\n';
+			}
+			return to_action_status( m_failed.empty( ) and not_run.empty( ) );
+		}
+	};
+} // namespace daw::glean
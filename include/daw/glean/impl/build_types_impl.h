@@ -42,6 +42,30 @@ namespace daw::glean::impl {
 	inline constexpr bool has_install_method_v =
 	  daw::is_detected_v<has_install_method_detect, T, Args...>;
 
+	template<typename T, typename... Args>
+	using has_build_inputs_method_detect =
+	  decltype( std::declval<T>( ).build_inputs( std::declval<Args>( )... ) );
+
+	template<typename T, typename... Args>
+	inline constexpr bool has_build_inputs_method_v =
+	  daw::is_detected_v<has_build_inputs_method_detect, T, Args...>;
+
+	template<typename T, typename... Args>
+	using has_is_installed_method_detect =
+	  decltype( std::declval<T>( ).is_installed( std::declval<Args>( )... ) );
+
+	template<typename T, typename... Args>
+	inline constexpr bool has_is_installed_method_v =
+	  daw::is_detected_v<has_is_installed_method_detect, T, Args...>;
+
+	template<typename T, typename... Args>
+	using has_install_manifest_method_detect = decltype(
+	  std::declval<T>( ).install_manifest( std::declval<Args>( )... ) );
+
+	template<typename T, typename... Args>
+	inline constexpr bool has_install_manifest_method_v =
+	  daw::is_detected_v<has_install_manifest_method_detect, T, Args...>;
+
 	template<typename T, typename... Args>
 	using can_construct_build_type_detect =
 	  decltype( daw::construct_a<T>( std::declval<Args>( )... ) );
@@ -0,0 +1,45 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief Whether any file listed in an install manifest contains one of
+	/// the strings.  Files that cannot be read count as containing them
+	[[nodiscard]] bool
+	installed_files_contain( fs::path const &manifest,
+	                         std::vector<std::string> const &needles );
+
+	/// @brief Remove every file listed in an install manifest, as far as they
+	/// can be
+	void remove_installed_files( fs::path const &manifest );
+
+	/// @brief Remove the files listed in a previous install's manifest that
+	/// are not among those installed now
+	void remove_stale_files( fs::path const &manifest,
+	                         std::vector<fs::path> const &installed );
+} // namespace daw::glean
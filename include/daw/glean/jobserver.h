@@ -0,0 +1,65 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utilities.h"
+
+namespace daw::glean {
+	/// @brief A GNU make style jobserver shared by every build glean starts.
+	/// The token pool is exported through MAKEFLAGS so that make, and ninja from
+	/// 1.13 on, draw from one budget instead of each running their own -j
+	class jobserver {
+		fs::path m_fifo_path{};
+		int m_fd = -1;
+		uint32_t m_jobs = 0;
+		bool m_use_fifo = true;
+
+	public:
+		/// @param jobs total number of jobs allowed across all builds
+		/// @param concurrent_builds number of top level builds run at once.  Each
+		/// of these already holds an implicit job slot
+		jobserver( uint32_t jobs, uint32_t concurrent_builds );
+		~jobserver( );
+
+		jobserver( jobserver const & ) = delete;
+		jobserver( jobserver && ) = delete;
+		jobserver &operator=( jobserver const & ) = delete;
+		jobserver &operator=( jobserver && ) = delete;
+
+		[[nodiscard]] bool is_active( ) const noexcept;
+		[[nodiscard]] std::string makeflags( ) const;
+
+		/// @brief Whether ninja builds take their job slots from the jobserver.
+		/// Older ninja, and any ninja when make needs the pipe form, ignore it
+		[[nodiscard]] bool ninja_joins( ) const;
+
+		/// @brief Environment a child process needs to join the jobserver
+		[[nodiscard]] std::vector<std::pair<std::string, std::string>>
+		environment( ) const;
+	};
+} // namespace daw::glean
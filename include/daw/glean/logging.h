@@ -64,6 +64,35 @@ namespace daw::glean {
 	}
 
 	logger const &operator<<( logger const &l, fs::path const &path );
+
+	/// @brief When set, every line a child process writes is shown prefixed
+	/// with its label.  Otherwise only a status line is shown and a child's
+	/// output is printed when it fails
+	void set_verbose_output( bool verbose ) noexcept;
+	[[nodiscard]] bool verbose_output( ) noexcept;
+
+	/// @brief Replace the single status line shown on an interactive console.
+	/// An empty status removes it.  Nothing is shown when stderr is not a
+	/// terminal
+	void log_status( std::string const &status );
+
+	/// @brief Label the child process output started from this thread, e.g.
+	/// with the dependency being worked on.  The previous label is restored
+	/// when the scope ends
+	class log_label_scope {
+		std::string m_previous;
+
+	public:
+		explicit log_label_scope( std::string label );
+		~log_label_scope( );
+
+		log_label_scope( log_label_scope const & ) = delete;
+		log_label_scope( log_label_scope && ) = delete;
+		log_label_scope &operator=( log_label_scope const & ) = delete;
+		log_label_scope &operator=( log_label_scope && ) = delete;
+	};
+
+	[[nodiscard]] std::string const &current_log_label( ) noexcept;
 } // namespace daw::glean
 
 inline constexpr daw::glean::logger log_message =
@@ -23,51 +23,77 @@
 #pragma once
 
 #include <algorithm>
-#include <boost/process.hpp>
+#include <cstdlib>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <daw/daw_traits.h>
+
+#include "logging.h"
 #include "utilities.h"
 
 namespace daw::glean {
+	/// @brief Settings for a single child process invocation.  Nothing here
+	/// touches the state of the glean process itself, so many can run at once
+	struct process_options {
+		/// @brief Folder to start the child in, empty means inherit ours
+		fs::path working_directory{};
+		/// @brief Variables set in the child's environment on top of ours.  An
+		/// empty value removes the variable
+		std::vector<std::pair<std::string, std::string>> environment{};
+	};
+
+	/// @brief Options to run a child process from within folder
+	[[nodiscard]] inline process_options in_folder( fs::path folder ) {
+		auto result = process_options( );
+		result.working_directory = std::move( folder );
+		return result;
+	}
+
+	struct process_result {
+		int exit_code = EXIT_FAILURE;
+		/// @brief Everything the child wrote to stdout
+		std::string output{};
+	};
+
+	/// @brief Run cmd, searched for on the PATH unless it is a path, to
+	/// completion.  On Linux every child is supervised by a single event loop
+	/// thread that reads their output without blocking and shows it labelled
+	/// with the current_log_label( ) of the thread that started it
+	[[nodiscard]] process_result run_process( std::string const &cmd,
+	                                          std::vector<std::string> args,
+	                                          process_options const &opts );
+
 	template<typename OutputIterator>
 	class Process {
 		OutputIterator m_out;
+		process_options m_options{};
 
 	public:
-		constexpr Process( OutputIterator out ) noexcept
+		explicit Process( OutputIterator out )
 		  : m_out( out ) {}
 
-		template<typename Cmd, typename... Args>
-		int operator( )( Cmd &&cmd, Args &&... args ) {
-
-			/*
-			  auto out = boost::process::ipstream( );
-			  auto err = boost::process::ipstream( );
-
-			  auto git_proc = boost::process::child(
-			    boost::process::search_path( cmd ), std::forward<Args>( args )...,
-			    boost::process::std_out > out, boost::process::std_err > err,
-			  boost::process::std_in < boost::process::null );
-			    */
-			return boost::process::system( boost::process::search_path( cmd ),
-			                               std::forward<Args>( args )... );
-			/*
-			  auto const process_pipe = [&]( auto &&p ) -> bool {
-			    auto line = std::string( );
-			    if( not p or not std::getline( p, line ) or line.empty( ) ) {
-			      return false;
-			    }
-			    line += '\n';
-			    m_out = std::copy( line.begin( ), line.end( ), m_out );
-			    return true;
-			  };
-			  while( git_proc and ( process_pipe( err ) or process_pipe( out ) ) ) {}
+		Process( OutputIterator out, process_options options )
+		  : m_out( out )
+		  , m_options( std::move( options ) ) {}
 
-			  git_proc.wait( );
-			  return git_proc.exit_code( );
-			  */
+		int operator( )( std::string const &cmd, std::vector<std::string> args ) {
+			auto result = run_process( cmd, std::move( args ), m_options );
+			if constexpr( not std::is_same_v<daw::remove_cvref_t<OutputIterator>,
+			                                 logger> ) {
+				// The console already shows the output of every child, anything
+				// else gets a copy of stdout
+				m_out =
+				  std::copy( result.output.cbegin( ), result.output.cend( ), m_out );
+			}
+			return result.exit_code;
 		}
 	};
 	template<typename OutputIterator>
 	Process( OutputIterator )->Process<OutputIterator>;
+
+	template<typename OutputIterator>
+	Process( OutputIterator, process_options )->Process<OutputIterator>;
 } // namespace daw::glean
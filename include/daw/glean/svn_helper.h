@@ -35,6 +35,7 @@
 namespace daw::glean {
 	template<typename SvnAction, typename OutputIterator>
 	action_status svn_runner( SvnAction &&svn_action, fs::path work_tree,
+	                          process_options proc_opts,
 	                          OutputIterator &&out_it ) {
 		auto args = svn_action.build_args( std::move( work_tree ) );
 		log_message << "Running svn";
@@ -43,7 +44,8 @@ namespace daw::glean {
 		}
 		log_message << "\n\n";
 
-		auto run_process = Process( std::forward<OutputIterator>( out_it ) );
+		auto run_process = Process( std::forward<OutputIterator>( out_it ),
+		                            std::move( proc_opts ) );
 		if( run_process( "svn", std::move( args ) ) == EXIT_SUCCESS ) {
 			return action_status::success;
 		}
@@ -54,6 +56,10 @@ namespace daw::glean {
 		std::vector<std::string> build_args( fs::path const &work_tree ) const;
 	};
 
+	struct svn_action_revision {
+		std::vector<std::string> build_args( fs::path const &work_tree ) const;
+	};
+
 	struct svn_action_checkout {
 		std::string remote_uri{};
 
@@ -0,0 +1,63 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace daw::glean {
+	/// @brief A fixed size pool of worker threads.  Tasks may be added from
+	/// any thread, including from within a running task.
+	class task_pool {
+		std::mutex m_mutex{};
+		std::condition_variable m_has_work{};
+		std::condition_variable m_is_idle{};
+		std::deque<std::function<void( )>> m_tasks{};
+		std::vector<std::thread> m_threads{};
+		size_t m_active = 0;
+		bool m_stop = false;
+
+		void worker( );
+
+	public:
+		explicit task_pool( uint32_t thread_count );
+		~task_pool( );
+
+		task_pool( task_pool const & ) = delete;
+		task_pool( task_pool && ) = delete;
+		task_pool &operator=( task_pool const & ) = delete;
+		task_pool &operator=( task_pool && ) = delete;
+
+		void add_task( std::function<void( )> task );
+
+		/// @brief Block until there are no queued or running tasks
+		void wait( );
+
+		[[nodiscard]] size_t size( ) const noexcept;
+	};
+} // namespace daw::glean
@@ -0,0 +1,54 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+
+#include "glean_options.h"
+
+namespace daw::glean {
+	/// @brief The compilers cmake picks for dependency builds and what they
+	/// target
+	struct toolchain_t {
+		/// @brief A digest of everything below along with the compiler related
+		/// environment variables and glean_options::cmake_args.  Anything reused
+		/// from another build must have been built with the same one
+		std::string id{};
+		std::string c_compiler{};
+		std::string c_version{};
+		std::string cxx_compiler{};
+		std::string cxx_version{};
+		std::string target{};
+		/// @brief Every compiler accepts -ffile-prefix-map
+		bool has_prefix_map = false;
+	};
+
+	/// @brief Find the toolchain by configuring an empty cmake project.  The
+	/// result is remembered under the glean cache until the cmake or compiler
+	/// binaries change, so only the first run pays for the probe.  Probed once
+	/// per run
+	[[nodiscard]] toolchain_t const &probe_toolchain( glean_options const &opts );
+
+	/// @brief The id of probe_toolchain( opts )
+	[[nodiscard]] std::string const &toolchain_id( glean_options const &opts );
+} // namespace daw::glean
@@ -30,9 +30,12 @@
 #endif
 
 //#include <curl/curl.h>
+#include <algorithm>
+#include <cctype>
 #include <exception>
 #include <mutex>
 #include <sstream>
+#include <string>
 
 #include <daw/daw_string_view.h>
 
@@ -47,42 +50,6 @@ namespace daw::glean {
 		std::mutex &get_curl_t_init_mutex( );
 	} // namespace impl
 
-	struct change_directory {
-		std::optional<fs::path> old_path;
-
-		inline change_directory( fs::path const &new_path ) {
-			fs::current_path( new_path );
-		}
-
-		inline void reset( ) noexcept {
-			if( auto tmp = std::exchange( old_path, std::nullopt ); tmp ) {
-				try {
-					if( exists( *tmp ) and is_directory( *tmp ) ) {
-						fs::current_path( *tmp );
-					}
-				} catch( ... ) {}
-			}
-		}
-
-		inline ~change_directory( ) noexcept {
-			reset( );
-		}
-
-		change_directory( change_directory &&other ) noexcept
-		  : old_path( std::exchange( other.old_path, std::nullopt ) ) {}
-
-		change_directory &operator=( change_directory &&rhs ) noexcept {
-			if( this != &rhs ) {
-				reset( );
-				old_path = std::exchange( rhs.old_path, std::nullopt );
-			}
-			return *this;
-		}
-
-		change_directory( change_directory const & ) = delete;
-		change_directory &operator=( change_directory const & ) = delete;
-	}; // change_directory
-
 	using glean_exception = std::runtime_error;
 
 	inline void verify_folder( fs::path const &path ) {
@@ -113,4 +80,48 @@ namespace daw::glean {
 		( result += ... += std::forward<Strings>( strs ) );
 		return result;
 	}
+
+	/// @brief Remove leading and trailing whitespace, such as the newline at
+	/// the end of a tool's output
+	[[nodiscard]] inline std::string trim( std::string str ) {
+		auto const is_space = []( char c ) {
+			return std::isspace( static_cast<unsigned char>( c ) ) != 0;
+		};
+		while( not str.empty( ) and is_space( str.back( ) ) ) {
+			str.pop_back( );
+		}
+		auto first = str.begin( );
+		while( first != str.end( ) and is_space( *first ) ) {
+			++first;
+		}
+		str.erase( str.begin( ), first );
+		return str;
+	}
+
+	/// @brief A canonical spelling of a repository uri, so that trivially
+	/// different spellings of one upstream are treated as the same.  The
+	/// scheme and host are lowercased and trailing slashes and .git removed
+	[[nodiscard]] inline std::string normalize_uri( std::string uri ) {
+		uri = trim( std::move( uri ) );
+		while( not uri.empty( ) and uri.back( ) == '/' ) {
+			uri.pop_back( );
+		}
+		if( uri.size( ) > 4 and uri.compare( uri.size( ) - 4, 4, ".git" ) == 0 ) {
+			uri.resize( uri.size( ) - 4 );
+		}
+		auto host_end = size_t( 0 );
+		if( auto const scheme = uri.find( "://" ); scheme != std::string::npos ) {
+			host_end = std::min( uri.find( '/', scheme + 3 ), uri.size( ) );
+		} else if( auto const colon = uri.find( ':' );
+		           colon != std::string::npos and colon > 1 and
+		           uri.find( '/' ) > colon ) {
+			// scp like user@host:path, a single letter is a Windows drive
+			host_end = colon;
+		}
+		for( size_t n = 0; n < host_end; ++n ) {
+			uri[n] = static_cast<char>(
+			  std::tolower( static_cast<unsigned char>( uri[n] ) ) );
+		}
+		return uri;
+	}
 } // namespace daw::glean
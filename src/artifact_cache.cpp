@@ -0,0 +1,223 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/artifact_cache.h"
+#include "daw/glean/cmake_helper.h"
+#include "daw/glean/digest.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/proc.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		// Other machines may be storing the same key into a shared folder, each
+		// writes its own file and renames it into place when complete
+		[[nodiscard]] fs::path unique_path( fs::path const &root,
+		                                    std::string const &key,
+		                                    std::string const &extension ) {
+			auto rd = std::random_device( );
+			return root / ( key + '.' + std::to_string( rd( ) ) + extension );
+		}
+
+		// Paths in an install manifest relative to install_root, or none when any
+		// is outside of it
+		[[nodiscard]] std::optional<std::vector<std::string>>
+		relative_paths( fs::path const &install_root, fs::path const &manifest ) {
+			auto in = std::ifstream( manifest );
+			if( not in ) {
+				return std::nullopt;
+			}
+			auto const root = install_root.generic_string( ) + '/';
+			auto result = std::vector<std::string>( );
+			auto line = std::string( );
+			while( std::getline( in, line ) ) {
+				if( line.empty( ) ) {
+					continue;
+				}
+				if( line.rfind( root, 0 ) != 0 ) {
+					log_message << "Not storing an artifact, '" << line
+					            << "' was installed outside of " << install_root
+					            << '\n';
+					return std::nullopt;
+				}
+				result.push_back( line.substr( root.size( ) ) );
+			}
+			return result;
+		}
+
+		// The files in a tar listing, or none when any member would be extracted
+		// outside of the folder.  Archives can come from a peer, the digest only
+		// shows that they were not corrupted
+		[[nodiscard]] std::optional<std::vector<std::string>>
+		archive_members( std::string const &key, std::string const &listing ) {
+			auto lines = std::istringstream( listing );
+			auto result = std::vector<std::string>( );
+			auto line = std::string( );
+			while( std::getline( lines, line ) ) {
+				line = trim( line );
+				if( line.empty( ) ) {
+					continue;
+				}
+				auto const member = fs::path( line );
+				auto const escapes =
+				  member.has_root_name( ) or member.has_root_directory( ) or
+				  std::any_of( member.begin( ), member.end( ),
+				               []( fs::path const &part ) { return part == ".."; } );
+				if( escapes ) {
+					log_message << "Artifact " << key << " has the member '" << line
+					            << "' outside of its install prefix\n";
+					return std::nullopt;
+				}
+				if( line.back( ) != '/' ) {
+					result.push_back( line );
+				}
+			}
+			return result;
+		}
+	} // namespace
+
+	artifact_cache::artifact_cache( fs::path root )
+	  : m_root( std::move( root ) ) {
+		verify_folder( m_root );
+	}
+
+	bool artifact_cache::contains( std::string const &key ) const {
+		return exists( archive_path( key ) ) and exists( digest_path( key ) );
+	}
+
+	fs::path artifact_cache::archive_path( std::string const &key ) const {
+		return m_root / ( key + ".tar.gz" );
+	}
+
+	fs::path artifact_cache::digest_path( std::string const &key ) const {
+		return m_root / ( key + ".sha256" );
+	}
+
+	std::string artifact_cache::digest( std::string const &key ) const {
+		auto in = std::ifstream( digest_path( key ) );
+		auto result = std::string( );
+		std::getline( in, result );
+		return result;
+	}
+
+	fs::path artifact_cache::partial_path( std::string const &key ) const {
+		return unique_path( m_root, key, ".partial" );
+	}
+
+	bool artifact_cache::commit( fs::path const &partial,
+	                             std::string const &key ) const {
+		auto const content_digest = sha256_file_hex( partial );
+		// Unlike a rename, a link fails when another machine got there first
+		try {
+			fs::create_hard_link( partial, archive_path( key ) );
+		} catch( fs::filesystem_error const & ) {
+			fs::remove( partial );
+			return false;
+		}
+		fs::remove( partial );
+		auto const digest_partial = unique_path( m_root, key, ".sha256.partial" );
+		{
+			auto out = std::ofstream( digest_partial, std::ios::trunc );
+			out << content_digest << '\n';
+		}
+		fs::rename( digest_partial, digest_path( key ) );
+		return true;
+	}
+
+	action_status artifact_cache::restore( std::string const &key,
+	                                       fs::path const &install_root,
+	                                       fs::path const &manifest ) const {
+		auto const archive = archive_path( key );
+		if( sha256_file_hex( archive ) != digest( key ) ) {
+			log_message << "Artifact " << key << " does not match its digest\n";
+			return action_status::failure;
+		}
+		fs::create_directories( install_root );
+		auto listing = std::string( );
+		if( not to_bool( cmake_runner( cmake_action_tar_list{archive},
+		                               install_root, build_types::release,
+		                               in_folder( install_root ),
+		                               std::back_inserter( listing ) ) ) ) {
+			return action_status::failure;
+		}
+		// Checked before anything is extracted, the manifest is used to remove
+		// the files again
+		auto const members = archive_members( key, listing );
+		if( not members or
+		    not to_bool( cmake_runner( cmake_action_tar_extract{archive},
+		                               install_root, build_types::release,
+		                               in_folder( install_root ),
+		                               log_message ) ) ) {
+			return action_status::failure;
+		}
+		fs::create_directories( manifest.parent_path( ) );
+		auto out = std::ofstream( manifest, std::ios::trunc );
+		for( auto const &member : *members ) {
+			out << ( install_root / member ).generic_string( ) << '\n';
+		}
+		return to_action_status( static_cast<bool>( out ) );
+	}
+
+	action_status artifact_cache::store( std::string const &key,
+	                                     fs::path const &install_root,
+	                                     fs::path const &manifest ) const {
+		if( contains( key ) ) {
+			return action_status::success;
+		}
+		auto const paths = relative_paths( install_root, manifest );
+		if( not paths ) {
+			return action_status::failure;
+		}
+		auto const file_list = unique_path( m_root, key, ".files" );
+		{
+			auto out = std::ofstream( file_list, std::ios::trunc );
+			for( auto const &path : *paths ) {
+				out << path << '\n';
+			}
+		}
+		auto const partial = partial_path( key );
+		auto result = cmake_runner( cmake_action_tar_create{partial, file_list},
+		                            install_root, build_types::release,
+		                            in_folder( install_root ), log_message );
+		fs::remove( file_list );
+		if( not to_bool( result ) ) {
+			if( exists( partial ) ) {
+				fs::remove( partial );
+			}
+			return result;
+		}
+		// Another machine may have stored the same key in the meantime
+		(void)commit( partial, key );
+		return action_status::success;
+	}
+} // namespace daw::glean
@@ -0,0 +1,511 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/artifact_cache.h"
+#include "daw/glean/artifact_http.h"
+#include "daw/glean/digest.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/task_pool.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		namespace net = boost::asio;
+		namespace http = boost::beast::http;
+		using tcp = boost::asio::ip::tcp;
+
+		constexpr int http_version = 11;
+		constexpr auto max_body_size = std::numeric_limits<std::uint64_t>::max( );
+		// A transfer is given up when no data moves for this long
+		constexpr auto io_timeout = std::chrono::seconds( 60 );
+		// Connections the server handles at once, more wait to be accepted
+		constexpr uint32_t max_connections = 32;
+		// The sha256_file_hex of an archive, sent along with every upload and
+		// download of it
+		constexpr char const digest_field[] = "X-Glean-Sha256";
+
+		// Keys are hex digests, nothing else may name a file in the store
+		[[nodiscard]] bool is_artifact_key( std::string const &key ) {
+			return key.size( ) >= 16U and key.size( ) <= 128U and
+			       std::all_of( key.begin( ), key.end( ), []( char c ) {
+				       return std::isxdigit( static_cast<unsigned char>( c ) ) != 0;
+			       } );
+		}
+
+		// Each connection has its own io_context, so that the thread using it
+		// can give up on an operation that stalls
+		struct connection_t {
+			net::io_context ioc{};
+			tcp::socket socket{ioc};
+			boost::beast::flat_buffer buffer{};
+
+			// Headers and bodies are written separately, without this each
+			// message waits on the peer's delayed acknowledgement
+			void set_no_delay( ) {
+				auto ec = boost::system::error_code( );
+				socket.set_option( tcp::no_delay( true ), ec );
+			}
+		};
+
+		// Runs the asynchronous operation that start begins until it completes.
+		// When it does not within io_timeout the socket is closed
+		template<typename Start>
+		[[nodiscard]] boost::system::error_code run_timed( connection_t &con,
+		                                                   Start start ) {
+			auto ec = boost::system::error_code( net::error::would_block );
+			start( [&ec]( boost::system::error_code e, auto &&... ) { ec = e; } );
+			con.ioc.restart( );
+			con.ioc.run_for( io_timeout );
+			if( not con.ioc.stopped( ) ) {
+				auto ignored = boost::system::error_code( );
+				con.socket.close( ignored );
+				con.ioc.run( );
+				return net::error::timed_out;
+			}
+			return ec;
+		}
+
+		template<typename Parser>
+		[[nodiscard]] boost::system::error_code read_header( connection_t &con,
+		                                                     Parser &parser ) {
+			auto ec = boost::system::error_code( );
+			while( not ec and not parser.is_header_done( ) ) {
+				ec = run_timed( con, [&]( auto handler ) {
+					http::async_read_some( con.socket, con.buffer, parser,
+					                       std::move( handler ) );
+				} );
+			}
+			return ec;
+		}
+
+		template<typename Parser>
+		[[nodiscard]] boost::system::error_code read( connection_t &con,
+		                                              Parser &parser ) {
+			auto ec = boost::system::error_code( );
+			while( not ec and not parser.is_done( ) ) {
+				ec = run_timed( con, [&]( auto handler ) {
+					http::async_read_some( con.socket, con.buffer, parser,
+					                       std::move( handler ) );
+				} );
+			}
+			return ec;
+		}
+
+		// Writes msg, or only its header
+		template<bool isRequest, typename Body>
+		[[nodiscard]] boost::system::error_code
+		write( connection_t &con, http::message<isRequest, Body> &msg,
+		       bool header_only = false ) {
+			auto serializer = http::serializer<isRequest, Body>( msg );
+			serializer.split( header_only );
+			auto ec = boost::system::error_code( );
+			while( not ec and not( header_only ? serializer.is_header_done( )
+			                                   : serializer.is_done( ) ) ) {
+				ec = run_timed( con, [&]( auto handler ) {
+					http::async_write_some( con.socket, serializer,
+					                        std::move( handler ) );
+				} );
+			}
+			return ec;
+		}
+
+		// Whether the connection can take another request after the response
+		template<typename Request>
+		[[nodiscard]] bool send_status( connection_t &con, Request const &req,
+		                                http::status status, bool keep_alive ) {
+			auto res = http::response<http::string_body>( status, req.version( ) );
+			res.keep_alive( keep_alive );
+			if( req.method( ) != http::verb::head ) {
+				res.body( ) = std::string( http::obsolete_reason( status ) ) + '\n';
+			}
+			res.prepare_payload( );
+			return not write( con, res ) and keep_alive;
+		}
+
+		// An archive is written once, an upload of a key that has one is
+		// refused.  The upload names the digest of its content, which must
+		// match what arrived
+		[[nodiscard]] bool
+		handle_upload( connection_t &con,
+		               http::request_parser<http::empty_body> &header,
+		               std::string const &key, artifact_cache const &store ) {
+			auto const partial = store.partial_path( key );
+			auto body = http::request_parser<http::file_body>( std::move( header ) );
+			body.body_limit( max_body_size );
+			auto ec = boost::system::error_code( );
+			body.get( ).body( ).open( partial.string( ).c_str( ),
+			                          boost::beast::file_mode::write, ec );
+			if( not ec ) {
+				ec = read( con, body );
+			}
+			body.get( ).body( ).close( );
+			if( ec ) {
+				if( exists( partial ) ) {
+					fs::remove( partial );
+				}
+				return false;
+			}
+			auto const &req = body.get( );
+			auto const expected = std::string( req[digest_field] );
+			if( store.contains( key ) ) {
+				fs::remove( partial );
+				return send_status( con, req, http::status::conflict,
+				                    req.keep_alive( ) );
+			}
+			if( expected.empty( ) or sha256_file_hex( partial ) != expected ) {
+				fs::remove( partial );
+				return send_status( con, req, http::status::bad_request,
+				                    req.keep_alive( ) );
+			}
+			if( not store.commit( partial, key ) ) {
+				return send_status( con, req, http::status::conflict,
+				                    req.keep_alive( ) );
+			}
+			return send_status( con, req, http::status::created, req.keep_alive( ) );
+		}
+
+		// Handles one request, false when the connection is done
+		[[nodiscard]] bool handle_request( connection_t &con,
+		                                   artifact_cache const &store ) {
+			auto header = http::request_parser<http::empty_body>( );
+			header.body_limit( max_body_size );
+			if( read_header( con, header ) ) {
+				return false;
+			}
+			auto const &req = header.get( );
+			// The body of anything but an upload is not read, the connection
+			// cannot be used after one
+			auto const keep_alive =
+			  req.keep_alive( ) and ( req.method( ) == http::verb::head or
+			                          req.method( ) == http::verb::get );
+			auto const target = std::string( req.target( ) );
+			auto const key = target.substr( target.find_last_of( '/' ) + 1 );
+			if( not is_artifact_key( key ) ) {
+				return send_status( con, req, http::status::not_found,
+				                    keep_alive and req.method( ) != http::verb::put );
+			}
+			switch( req.method( ) ) {
+			case http::verb::head: {
+				if( not store.contains( key ) ) {
+					return send_status( con, req, http::status::not_found, keep_alive );
+				}
+				auto res =
+				  http::response<http::empty_body>( http::status::ok, req.version( ) );
+				res.keep_alive( keep_alive );
+				res.content_length( fs::file_size( store.archive_path( key ) ) );
+				res.set( digest_field, store.digest( key ) );
+				return not write( con, res, true ) and keep_alive;
+			}
+			case http::verb::get: {
+				auto res =
+				  http::response<http::file_body>( http::status::ok, req.version( ) );
+				auto ec = boost::system::error_code( );
+				if( store.contains( key ) ) {
+					res.body( ).open( store.archive_path( key ).string( ).c_str( ),
+					                  boost::beast::file_mode::scan, ec );
+				}
+				if( ec or not store.contains( key ) ) {
+					return send_status( con, req, http::status::not_found, keep_alive );
+				}
+				res.keep_alive( keep_alive );
+				res.set( http::field::content_type, "application/gzip" );
+				res.set( digest_field, store.digest( key ) );
+				res.prepare_payload( );
+				return not write( con, res ) and keep_alive;
+			}
+			case http::verb::put:
+				return handle_upload( con, header, key, store );
+			default:
+				return send_status( con, req, http::status::method_not_allowed,
+				                    false );
+			}
+		}
+
+		void handle_connection( connection_t &con, artifact_cache const &store ) {
+			while( handle_request( con, store ) ) {}
+			auto ec = boost::system::error_code( );
+			con.socket.shutdown( tcp::socket::shutdown_send, ec );
+		}
+
+		// Accepting waits while max_connections are being handled
+		class connection_slots {
+			std::mutex m_mutex{};
+			std::condition_variable m_has_slot{};
+			uint32_t m_free_slots = max_connections;
+
+		public:
+			void acquire( ) {
+				auto lck = std::unique_lock<std::mutex>( m_mutex );
+				m_has_slot.wait( lck, [&] { return m_free_slots > 0; } );
+				--m_free_slots;
+			}
+
+			void release( ) {
+				{
+					auto const lck = std::lock_guard<std::mutex>( m_mutex );
+					++m_free_slots;
+				}
+				m_has_slot.notify_one( );
+			}
+		};
+	} // namespace
+
+	action_status serve_artifact_cache( artifact_cache const &store,
+	                                    std::string const &address,
+	                                    uint16_t port ) {
+		auto ec = boost::system::error_code( );
+		auto const ip = net::ip::make_address( address, ec );
+		if( ec ) {
+			log_error << "Invalid address to serve the cache on '" << address
+			          << "'\n";
+			return action_status::failure;
+		}
+		auto ioc = net::io_context( );
+		auto acceptor = tcp::acceptor( ioc );
+		auto const endpoint = tcp::endpoint( ip, port );
+		acceptor.open( endpoint.protocol( ), ec );
+		if( not ec ) {
+			acceptor.set_option( net::socket_base::reuse_address( true ), ec );
+			acceptor.bind( endpoint, ec );
+		}
+		if( not ec ) {
+			acceptor.listen( net::socket_base::max_listen_connections, ec );
+		}
+		if( ec ) {
+			log_error << "Could not listen on " << address << ':'
+			          << std::to_string( port ) << ": " << ec.message( ) << '\n';
+			return action_status::failure;
+		}
+		log_message << "Serving artifacts on http://" << address << ':'
+		            << std::to_string( port ) << '\n';
+		auto slots = connection_slots( );
+		auto pool = task_pool( max_connections );
+		while( true ) {
+			slots.acquire( );
+			auto con = std::make_shared<connection_t>( );
+			acceptor.accept( con->socket, ec );
+			if( ec ) {
+				slots.release( );
+				continue;
+			}
+			con->set_no_delay( );
+			pool.add_task( [con, &store, &slots]( ) {
+				try {
+					handle_connection( *con, store );
+				} catch( std::exception const &ex ) {
+					log_error << "Artifact server connection failed: " << ex.what( )
+					          << '\n';
+				}
+				slots.release( );
+			} );
+		}
+	}
+
+	class artifact_client::transfer_slot {
+		artifact_client *m_client;
+
+	public:
+		explicit transfer_slot( artifact_client &client )
+		  : m_client( &client ) {
+			auto lck = std::unique_lock<std::mutex>( m_client->m_mutex );
+			m_client->m_has_slot.wait(
+			  lck, [&] { return m_client->m_free_slots > 0; } );
+			--m_client->m_free_slots;
+		}
+
+		~transfer_slot( ) {
+			{
+				auto const lck = std::lock_guard<std::mutex>( m_client->m_mutex );
+				++m_client->m_free_slots;
+			}
+			m_client->m_has_slot.notify_one( );
+		}
+
+		transfer_slot( transfer_slot const & ) = delete;
+		transfer_slot( transfer_slot && ) = delete;
+		transfer_slot &operator=( transfer_slot const & ) = delete;
+		transfer_slot &operator=( transfer_slot && ) = delete;
+	};
+
+	namespace {
+		[[nodiscard]] bool connect( connection_t &con, std::string const &host,
+		                            std::string const &port ) {
+			auto ec = boost::system::error_code( );
+			auto resolver = tcp::resolver( con.ioc );
+			auto const endpoints = resolver.resolve( host, port, ec );
+			if( not ec ) {
+				ec = run_timed( con, [&]( auto handler ) {
+					net::async_connect( con.socket, endpoints, std::move( handler ) );
+				} );
+			}
+			if( ec ) {
+				log_message << "Could not connect to the artifact server " << host
+				            << ':' << port << ": " << ec.message( ) << '\n';
+				return false;
+			}
+			con.set_no_delay( );
+			return true;
+		}
+
+		template<typename Body>
+		[[nodiscard]] http::request<Body>
+		make_request( http::verb method, std::string const &host,
+		              std::string const &target ) {
+			auto req = http::request<Body>( method, target, http_version );
+			req.set( http::field::host, host );
+			req.set( http::field::user_agent, "glean" );
+			req.keep_alive( false );
+			return req;
+		}
+	} // namespace
+
+	artifact_client::artifact_client( std::string const &url,
+	                                  uint32_t max_transfers )
+	  : m_free_slots( std::max( max_transfers, 1U ) ) {
+		static constexpr daw::string_view scheme = "http://";
+		if( url.compare( 0, scheme.size( ), scheme.data( ), scheme.size( ) ) !=
+		    0 ) {
+			log_error << "Only http:// artifact servers are supported, not '" << url
+			          << "'\n";
+			exit( EXIT_FAILURE );
+		}
+		auto const authority_end = url.find( '/', scheme.size( ) );
+		auto const authority =
+		  url.substr( scheme.size( ), authority_end - scheme.size( ) );
+		if( authority_end != std::string::npos ) {
+			m_base_path = url.substr( authority_end );
+		}
+		while( not m_base_path.empty( ) and m_base_path.back( ) == '/' ) {
+			m_base_path.pop_back( );
+		}
+		auto const colon = authority.rfind( ':' );
+		m_host = authority.substr( 0, colon );
+		m_port = colon == std::string::npos ? "80" : authority.substr( colon + 1 );
+		if( m_host.empty( ) or m_port.empty( ) ) {
+			log_error << "Invalid artifact server '" << url << "'\n";
+			exit( EXIT_FAILURE );
+		}
+	}
+
+	bool artifact_client::contains( std::string const &key ) {
+		auto const slot = transfer_slot( *this );
+		auto con = connection_t( );
+		if( not connect( con, m_host, m_port ) ) {
+			return false;
+		}
+		auto req = make_request<http::empty_body>( http::verb::head, m_host,
+		                                           m_base_path + '/' + key );
+		auto ec = write( con, req );
+		auto res = http::response_parser<http::empty_body>( );
+		// The content length of a HEAD response has no body behind it
+		res.skip( true );
+		if( not ec ) {
+			ec = read( con, res );
+		}
+		return not ec and res.get( ).result( ) == http::status::ok;
+	}
+
+	action_status artifact_client::download( std::string const &key,
+	                                         fs::path const &file ) {
+		auto const slot = transfer_slot( *this );
+		auto con = connection_t( );
+		if( not connect( con, m_host, m_port ) ) {
+			return action_status::failure;
+		}
+		auto req = make_request<http::empty_body>( http::verb::get, m_host,
+		                                           m_base_path + '/' + key );
+		auto ec = write( con, req );
+		auto res = http::response_parser<http::file_body>( );
+		res.body_limit( max_body_size );
+		if( not ec ) {
+			res.get( ).body( ).open( file.string( ).c_str( ),
+			                         boost::beast::file_mode::write, ec );
+		}
+		if( not ec ) {
+			ec = read( con, res );
+		}
+		res.get( ).body( ).close( );
+		if( ec or res.get( ).result( ) != http::status::ok ) {
+			return action_status::failure;
+		}
+		auto const expected = std::string( res.get( )[digest_field] );
+		if( expected.empty( ) or sha256_file_hex( file ) != expected ) {
+			log_message << "Artifact " << key
+			            << " from the server does not match its digest\n";
+			return action_status::failure;
+		}
+		return action_status::success;
+	}
+
+	action_status artifact_client::upload( std::string const &key,
+	                                       fs::path const &file ) {
+		auto const content_digest = sha256_file_hex( file );
+		if( content_digest.empty( ) ) {
+			return action_status::failure;
+		}
+		auto const slot = transfer_slot( *this );
+		auto con = connection_t( );
+		if( not connect( con, m_host, m_port ) ) {
+			return action_status::failure;
+		}
+		auto ec = boost::system::error_code( );
+		auto req = make_request<http::file_body>( http::verb::put, m_host,
+		                                          m_base_path + '/' + key );
+		req.body( ).open( file.string( ).c_str( ), boost::beast::file_mode::scan,
+		                  ec );
+		if( ec ) {
+			return action_status::failure;
+		}
+		req.set( http::field::content_type, "application/gzip" );
+		req.set( digest_field, content_digest );
+		req.prepare_payload( );
+		ec = write( con, req );
+		auto res = http::response_parser<http::string_body>( );
+		if( not ec ) {
+			ec = read( con, res );
+		}
+		// A conflict is the server already having the key, archives are never
+		// replaced
+		return to_action_status(
+		  not ec and ( res.get( ).result( ) == http::status::created or
+		               res.get( ).result( ) == http::status::conflict ) );
+	}
+} // namespace daw::glean
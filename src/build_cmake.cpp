@@ -20,17 +20,24 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <fstream>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "daw/glean/build_cmake.h"
+#include "daw/glean/cache_lock.h"
 #include "daw/glean/cmake_helper.h"
+#include "daw/glean/digest.h"
 #include "daw/glean/glean_file.h"
 #include "daw/glean/glean_file_item.h"
 #include "daw/glean/glean_options.h"
+#include "daw/glean/install_manifest.h"
 #include "daw/glean/logging.h"
 #include "daw/glean/proc.h"
+#include "daw/glean/toolchain.h"
 #include "daw/glean/utilities.h"
 
 namespace daw::glean {
@@ -49,45 +56,445 @@ namespace daw::glean {
 		return {pos, action_status::failure};
 	}
 
+	namespace {
+		[[nodiscard]] process_options
+		cmake_process_options( fs::path const &cache_path,
+		                       glean_options const &opts ) {
+			auto result = in_folder( cache_path / "build" );
+			result.environment = opts.build_environment;
+			return result;
+		}
+
+		// Switches that turn off what is never used from a dependency, under the
+		// names that are common or that widely used projects chose
+		constexpr char const *const minimal_profile_args[] = {
+		  "--no-warn-unused-cli",
+		  "-DBUILD_TESTING=OFF",
+		  "-DBUILD_EXAMPLES=OFF",
+		  "-DBUILD_BENCHMARKS=OFF",
+		  "-DBUILD_DOCS=OFF",
+		  "-DDAW_ENABLE_TESTING=OFF",
+		  "-DFMT_TEST=OFF",
+		  "-DFMT_DOC=OFF",
+		  "-DJSON_BuildTests=OFF",
+		  "-DBENCHMARK_ENABLE_TESTING=OFF",
+		  "-DSPDLOG_BUILD_TESTS=OFF",
+		  "-DSPDLOG_BUILD_EXAMPLE=OFF",
+		  "-DSPDLOG_BUILD_BENCH=OFF",
+		  "-DCATCH_BUILD_TESTING=OFF",
+		  "-DCATCH_INSTALL_DOCS=OFF"};
+
+		// Compile flags that replace the cache and install prefix paths in
+		// debug info, __FILE__ and the like with the same ones on every machine
+		[[nodiscard]] std::string
+		prefix_map_flags( build_cmake const &self,
+		                  glean_file_item const &dep_item ) {
+			auto const map = [&]( fs::path const &from, std::string const &to ) {
+				return "-ffile-prefix-map=" + from.string( ) + '=' + to;
+			};
+			auto const root = "/glean/" + dep_item.provides;
+			return map( self.m_cache_path / "source", root + "/source" ) + ' ' +
+			       map( self.m_cache_path / "build", root + "/build" ) + ' ' +
+			       map( self.m_install_prefix, "/glean/prefix" );
+		}
+
+		[[nodiscard]] cmake_action_configure
+		configure_action( build_cmake const &self, daw::glean::build_types bt,
+		                  glean_file_item const &dep_item ) {
+			auto args = std::vector<std::string>( );
+			// The _INIT flags are added to any given by the environment or the
+			// arguments that follow
+			if( self.m_opt->relocatable and
+			    probe_toolchain( *self.m_opt ).has_prefix_map ) {
+				auto const flags = prefix_map_flags( self, dep_item );
+				args.push_back( "-DCMAKE_C_FLAGS_INIT=" + flags );
+				args.push_back( "-DCMAKE_CXX_FLAGS_INIT=" + flags );
+			}
+			// Before the glean and dependency arguments, so that they can turn
+			// any of it back on
+			if( self.m_opt->build_profile == build_profiles::minimal ) {
+				args.insert( args.end( ), std::begin( minimal_profile_args ),
+				             std::end( minimal_profile_args ) );
+			}
+			std::copy_if( self.m_opt->cmake_args.cbegin( ),
+			              self.m_opt->cmake_args.cend( ), std::back_inserter( args ),
+			              []( std::string const &s ) { return not s.empty( ); } );
+			std::copy_if( dep_item.cmake_args.cbegin( ), dep_item.cmake_args.cend( ),
+			              std::back_inserter( args ),
+			              []( std::string const &s ) { return not s.empty( ); } );
+			if( not self.is_multi_config( ) ) {
+				args.push_back( "-DCMAKE_BUILD_TYPE=" + cmake_config_name( bt ) );
+			}
+			auto result =
+			  cmake_action_configure( self.m_cache_path / "source",
+			                          self.m_install_prefix, std::move( args ),
+			                          self.m_has_glean );
+			result.compiler_launcher = self.m_opt->compiler_launcher;
+			result.multi_config = self.is_multi_config( );
+			return result;
+		}
+
+		// The folder cmake configures for the build type
+		[[nodiscard]] fs::path build_folder( build_cmake const &self,
+		                                     daw::glean::build_types bt ) {
+			if( self.is_multi_config( ) ) {
+				return self.m_cache_path / "build" / multi_config_folder;
+			}
+			return self.m_cache_path / "build" / to_string( bt );
+		}
+
+		// Whether the build tool of the configured folder takes its job slots
+		// from glean's jobserver.  GNU make does, ninja only when it is new
+		// enough, and the others run their own jobs
+		[[nodiscard]] bool joins_jobserver( build_cmake const &self,
+		                                    daw::glean::build_types bt ) {
+			if( not self.m_opt->use_jobserver ) {
+				return false;
+			}
+			static constexpr daw::string_view key = "CMAKE_GENERATOR:INTERNAL=";
+			auto in = std::ifstream( build_folder( self, bt ) / "CMakeCache.txt" );
+			auto line = std::string( );
+			while( std::getline( in, line ) ) {
+				if( line.compare( 0, key.size( ), key ) != 0 ) {
+					continue;
+				}
+				auto const generator = line.substr( key.size( ) );
+				if( generator.compare( 0, 5, "Ninja" ) == 0 ) {
+					return self.m_opt->ninja_joins_jobserver;
+				}
+				return generator == "Unix Makefiles" or
+				       generator == "MinGW Makefiles" or
+				       generator == "MSYS Makefiles";
+			}
+			return false;
+		}
+
+		// A build outside the jobserver gets its share of --jobs, so that the
+		// concurrent builds together do not run more
+		[[nodiscard]] uint32_t parallel_jobs( glean_options const &opts ) {
+			return std::max( 1U, opts.jobs / std::max( 1U, opts.build_jobs ) );
+		}
+
+		// Left once a debug install from the multi-config folder named the
+		// release prefix, every build type then gets its own folder
+		[[nodiscard]] fs::path per_build_type_marker( fs::path const &cache_path ) {
+			return cache_path / "build" /
+			       ( std::string( multi_config_folder ) + ".per_build_type" );
+		}
+
+		// Held exclusively while configuring, building or installing from the
+		// multi-config folder, which debug and release share
+		[[nodiscard]] fs::path multi_config_lock_file( build_cmake const &self ) {
+			return self.m_cache_path / "build" /
+			       ( std::string( multi_config_folder ) + ".lock" );
+		}
+
+		[[nodiscard]] bool is_cmake_file( fs::path const &file ) {
+			return file.filename( ) == "CMakeLists.txt" or
+			       file.extension( ) == ".cmake";
+		}
+
+		// Adds the path, relative to root, and the content of every cmake file
+		// below folder in a stable order
+		void hash_cmake_files( sha256 &digest, fs::path const &root,
+		                       fs::path const &folder ) {
+			auto items = std::vector<fs::path>( );
+			for( auto const &item : fs::directory_iterator( folder ) ) {
+				if( item.path( ).filename( ) != ".git" ) {
+					items.push_back( item.path( ) );
+				}
+			}
+			std::sort( items.begin( ), items.end( ) );
+			for( auto const &item : items ) {
+				if( is_directory( item ) ) {
+					hash_cmake_files( digest, root, item );
+					continue;
+				}
+				if( not is_cmake_file( item ) ) {
+					continue;
+				}
+				auto in = std::ifstream( item, std::ios::binary );
+				auto content = std::string( std::istreambuf_iterator<char>( in ),
+				                            std::istreambuf_iterator<char>( ) );
+				digest
+				  .update_field( item.lexically_relative( root ).generic_string( ) )
+				  .update_field( content );
+			}
+		}
+
+		// What a configure of the build folder depends on.  Files that the
+		// configure reads from elsewhere, such as the package files of
+		// dependencies, are checked by the generated build system itself, which
+		// reconfigures when they change
+		struct configure_stamp_t {
+			// The command line and the toolchain it runs with
+			std::string command{};
+			// The cmake files of the source
+			std::string files{};
+
+			[[nodiscard]] bool operator==( configure_stamp_t const &rhs ) const {
+				return command == rhs.command and files == rhs.files;
+			}
+		};
+
+		[[nodiscard]] configure_stamp_t
+		configure_stamp( build_cmake const &self, daw::glean::build_types bt,
+		                 glean_file_item const &dep_item ) {
+			auto command = sha256( );
+			command.update_field( "glean configure 3" )
+			  .update_field( toolchain_id( *self.m_opt ) );
+			// The same for every build type of a multi-config folder
+			auto const args = configure_action( self, bt, dep_item )
+			                    .build_args( self.m_cache_path / "build", bt );
+			for( auto const &arg : args ) {
+				command.update_field( arg );
+			}
+			auto files = sha256( );
+			hash_cmake_files( files, self.m_cache_path / "source",
+			                  self.m_cache_path / "source" );
+			return {command.hex_digest( ), files.hex_digest( )};
+		}
+
+		[[nodiscard]] fs::path configure_stamp_file( build_cmake const &self,
+		                                             daw::glean::build_types bt ) {
+			return build_folder( self, bt ) / "glean_configure.stamp";
+		}
+
+		[[nodiscard]] configure_stamp_t
+		read_configure_stamp( fs::path const &file ) {
+			auto result = configure_stamp_t( );
+			auto in = std::ifstream( file );
+			std::getline( in, result.command );
+			std::getline( in, result.files );
+			return result;
+		}
+
+		void write_configure_stamp( fs::path const &file,
+		                            configure_stamp_t const &stamp ) {
+			auto out = std::ofstream( file, std::ios::trunc );
+			out << stamp.command << '\n' << stamp.files << '\n';
+		}
+
+		// Installed cmake and pkg-config files often name the install prefix
+		// they were configured with.  Each such file gets the prefix it is in
+		// from its own location instead, so that the files are the same
+		// wherever the prefix is
+		void make_package_files_relocatable( fs::path const &manifest,
+		                                     fs::path const &prefix,
+		                                     fs::path const &configured_prefix ) {
+			auto const prefix_str = configured_prefix.generic_string( );
+			auto in = std::ifstream( manifest );
+			auto line = std::string( );
+			while( std::getline( in, line ) ) {
+				auto const file = fs::path( line );
+				auto const ext = file.extension( );
+				if( ( ext != ".cmake" and ext != ".pc" ) or is_symlink( file ) or
+				    not is_regular_file( file ) ) {
+					continue;
+				}
+				auto content = [&] {
+					auto f = std::ifstream( file, std::ios::binary );
+					return std::string( std::istreambuf_iterator<char>( f ),
+					                    std::istreambuf_iterator<char>( ) );
+				}( );
+				if( content.find( prefix_str ) == std::string::npos ) {
+					continue;
+				}
+				auto const up =
+				  prefix.lexically_relative( file.parent_path( ) ).generic_string( );
+				// Functions in a cmake file can run after another file is included,
+				// when CMAKE_CURRENT_LIST_DIR is no longer this one's
+				auto const replacement =
+				  ext == ".pc" ? "${pcfiledir}/" + up : "${_glean_install_prefix}";
+				for( auto pos = content.find( prefix_str ); pos != std::string::npos;
+				     pos = content.find( prefix_str, pos + replacement.size( ) ) ) {
+					content.replace( pos, prefix_str.size( ), replacement );
+				}
+				if( ext == ".cmake" ) {
+					content = "get_filename_component( _glean_install_prefix "
+					          "\"${CMAKE_CURRENT_LIST_DIR}/" +
+					          up + "\" ABSOLUTE )\n" + content;
+				}
+				auto out = std::ofstream( file, std::ios::binary | std::ios::trunc );
+				out << content;
+			}
+		}
+
+		// cmake --install builds nothing and goes to any prefix, the install target
+		// would go to the release prefix the folder is configured with
+		[[nodiscard]] action_status
+		install_config( build_cmake const &self, daw::glean::build_types bt ) {
+			auto const multi_config_lck =
+			  cache_lock( multi_config_lock_file( self ), lock_modes::exclusive );
+			if( not to_bool( cmake_runner(
+			      cmake_action_install_config{self.m_install_prefix},
+			      self.m_cache_path / "build", bt,
+			      cmake_process_options( self.m_cache_path, *self.m_opt ),
+			      log_message ) ) ) {
+				return action_status::failure;
+			}
+			// Each install replaces the shared folder's manifest, it is kept with
+			// the build type that wrote it
+			auto const shared_manifest =
+			  build_folder( self, bt ) / "install_manifest.txt";
+			if( not exists( shared_manifest ) ) {
+				log_error << "cmake --install did not write " << shared_manifest
+				          << '\n';
+				return action_status::failure;
+			}
+			auto const manifest = self.install_manifest( bt );
+			fs::create_directories( manifest.parent_path( ) );
+			fs::rename( shared_manifest, manifest );
+			return action_status::success;
+		}
+	} // namespace
+
 	build_cmake::build_cmake( fs::path const &cache_path,
 	                          fs::path const &install_prefix,
-	                          glean_options const &opts, bool has_glean ) noexcept
+	                          glean_options const &opts, bool has_glean )
 	  : m_cache_path( cache_path )
 	  , m_install_prefix( install_prefix )
 	  , m_opt( &opts )
-	  , m_has_glean( has_glean ) {}
+	  , m_has_glean( has_glean )
+	  , m_multi_config( opts.multi_config and not has_glean and
+	                    not exists( per_build_type_marker( cache_path ) ) ) {}
 
 	action_status build_cmake::build( daw::glean::build_types bt,
 	                                  glean_file_item const &m_dep_item ) const {
 		assert( m_opt != nullptr );
-		auto const chdir = change_directory( m_cache_path / "build" );
-		auto args = std::vector<std::string>( );
-		std::copy_if( m_opt->cmake_args.cbegin( ), m_opt->cmake_args.cend( ),
-		              std::back_inserter( args ),
-		              []( std::string const &s ) { return not s.empty( ); } );
-		std::copy_if( m_dep_item.cmake_args.cbegin( ),
-		              m_dep_item.cmake_args.cend( ), std::back_inserter( args ),
-		              []( std::string const &s ) { return not s.empty( ); } );
-		if( m_opt->build_type == daw::glean::build_types::debug ) {
-			args.push_back( "-DCMAKE_BUILD_TYPE=Debug" );
+		auto multi_config_lck = std::optional<cache_lock>( );
+		if( is_multi_config( ) ) {
+			multi_config_lck.emplace( multi_config_lock_file( *this ),
+			                          lock_modes::exclusive );
+		}
+		auto const stamp = configure_stamp( *this, bt, m_dep_item );
+		auto const stamp_file = configure_stamp_file( *this, bt );
+		auto const old_stamp = read_configure_stamp( stamp_file );
+		auto const cmake_cache = build_folder( *this, bt ) / "CMakeCache.txt";
+		if( old_stamp == stamp and exists( cmake_cache ) ) {
+			log_message << "Configure inputs are unchanged, not reconfiguring\n";
 		} else {
-			args.push_back( "-DCMAKE_BUILD_TYPE=Release" );
+			// A configure that fails part way must not leave an old match behind
+			if( exists( stamp_file ) ) {
+				fs::remove( stamp_file );
+			}
+			// Cached values from another command line would outlive it, and the
+			// _INIT flags are only read by the first configure
+			if( old_stamp.command != stamp.command and exists( cmake_cache ) ) {
+				fs::remove( cmake_cache );
+			}
+			if( not to_bool( cmake_runner(
+			      configure_action( *this, bt, m_dep_item ), m_cache_path / "build",
+			      bt, cmake_process_options( m_cache_path, *m_opt ),
+			      log_message ) ) ) {
+
+				return action_status::failure;
+			}
+			write_configure_stamp( stamp_file, stamp );
 		}
+		if( m_opt->build_profile == build_profiles::minimal and
+		    not is_multi_config( ) ) {
+			// install builds what it needs, a separate build would only add the
+			// targets install does not use
+			return action_status::success;
+		}
+		auto action = cmake_action_build( parallel_jobs( *m_opt ),
+		                                  joins_jobserver( *this, bt ) );
+		action.multi_config = is_multi_config( );
+		return cmake_runner( action, m_cache_path / "build", bt,
+		                     cmake_process_options( m_cache_path, *m_opt ),
+		                     log_message );
+	}
 
+	action_status build_cmake::install( daw::glean::build_types bt,
+	                                    glean_file_item const &file_dep ) const {
+		assert( m_opt != nullptr );
+		auto const prefix = m_install_prefix / to_string( bt );
+		if( is_multi_config( ) ) {
+			if( not to_bool( install_config( *this, bt ) ) ) {
+				return action_status::failure;
+			}
+			auto const configured_prefix =
+			  m_install_prefix / to_string( daw::glean::build_types::release );
+			if( m_opt->relocatable or prefix != configured_prefix ) {
+				make_package_files_relocatable( install_manifest( bt ), prefix,
+				                                configured_prefix );
+			}
+			// Rpaths, configured headers and the like still name the prefix the
+			// folder was configured with
+			if( prefix != configured_prefix and
+			    installed_files_contain( install_manifest( bt ),
+			                             {configured_prefix.string( )} ) ) {
+				log_message << "Installed " << to_string( bt )
+				            << " files name the release prefix, building each build "
+				               "type in its own folder\n";
+				remove_installed_files( install_manifest( bt ) );
+				fs::remove( install_manifest( bt ) );
+				{
+					auto marker = std::ofstream( per_build_type_marker( m_cache_path ) );
+				}
+				auto single = *this;
+				single.m_multi_config = false;
+				if( not to_bool( single.build( bt, file_dep ) ) ) {
+					return action_status::failure;
+				}
+				return single.install( bt, file_dep );
+			}
+			return action_status::success;
+		}
+		auto const action = m_opt->build_profile == build_profiles::minimal
+		                      ? cmake_action_install( parallel_jobs( *m_opt ),
+		                                              joins_jobserver( *this, bt ) )
+		                      : cmake_action_install( );
 		if( not to_bool( cmake_runner(
-		      cmake_action_configure( m_cache_path / "source", m_install_prefix,
-		                              std::move( args ), m_has_glean ),
-		      m_cache_path / "build", bt, log_message ) ) ) {
-
+		      action, m_cache_path / "build", bt,
+		      cmake_process_options( m_cache_path, *m_opt ), log_message ) ) ) {
 			return action_status::failure;
 		}
-		return cmake_runner( cmake_action_build( m_opt->jobs ),
-		                     m_cache_path / "build", bt, log_message );
+		if( m_opt->relocatable ) {
+			make_package_files_relocatable( install_manifest( bt ), prefix,
+			                                prefix );
+		}
+		return action_status::success;
 	}
 
-	action_status build_cmake::install( daw::glean::build_types bt ) const {
-		auto const chdir = change_directory( m_cache_path / "build" );
-		return cmake_runner( cmake_action_install( ), m_cache_path / "build", bt,
-		                     log_message );
+	std::vector<std::string>
+	build_cmake::build_inputs( daw::glean::build_types bt,
+	                           glean_file_item const &dep_item ) const {
+		assert( m_opt != nullptr );
+		auto action = configure_action( *this, bt, dep_item );
+		// A compiler cache does not change what is built, turning one on or off
+		// must not rebuild everything
+		action.compiler_launcher.clear( );
+		auto result = action.build_args( m_cache_path / "build", bt );
+		if( is_multi_config( ) ) {
+			// The configure is the same for every build type
+			result.push_back( "--config" );
+			result.push_back( cmake_config_name( bt ) );
+		}
+		return result;
+	}
+
+	bool build_cmake::is_multi_config( ) const {
+		return m_multi_config;
+	}
+
+	bool build_cmake::is_installed( daw::glean::build_types bt ) const {
+		auto manifest = std::ifstream( install_manifest( bt ) );
+		if( not manifest ) {
+			return false;
+		}
+		auto line = std::string( );
+		while( std::getline( manifest, line ) ) {
+			if( not line.empty( ) and not exists( fs::path( line ) ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	fs::path
+	build_cmake::install_manifest( daw::glean::build_types bt ) const {
+		return m_cache_path / "build" / to_string( bt ) / "install_manifest.txt";
 	}
 } // namespace daw::glean
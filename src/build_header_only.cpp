@@ -0,0 +1,183 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/build_header_only.h"
+#include "daw/glean/glean_file_item.h"
+#include "daw/glean/glean_options.h"
+#include "daw/glean/install_manifest.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		// Finds the prefix from its own location, so the prefix can be moved.
+		// The packages of the dependencies are found first and linked to
+		[[nodiscard]] std::string
+		package_config( std::string const &provides,
+		                cmake_package_t const &package,
+		                std::vector<cmake_package_t> const &dependencies ) {
+			auto const &target = package.target;
+			auto result =
+			  "# Generated by glean for the header only " + provides + '\n';
+			auto links = std::string( );
+			if( not dependencies.empty( ) ) {
+				result += "include( CMakeFindDependencyMacro )\n";
+				for( auto const &dep : dependencies ) {
+					result += "find_dependency( " + dep.name + " )\n";
+					links += links.empty( ) ? dep.target : ';' + dep.target;
+				}
+			}
+			// After the dependencies, their own package files may set it too
+			result += "get_filename_component( _glean_install_prefix "
+			          "\"${CMAKE_CURRENT_LIST_DIR}/../../..\" ABSOLUTE )\n";
+			result += "if( NOT TARGET " + target + " )\n";
+			result += "\tadd_library( " + target + " INTERFACE IMPORTED )\n";
+			result += "\tset_target_properties( " + target + " PROPERTIES\n";
+			result += "\t\tINTERFACE_INCLUDE_DIRECTORIES "
+			          "\"${_glean_install_prefix}/include\"";
+			if( not links.empty( ) ) {
+				result += "\n\t\tINTERFACE_LINK_LIBRARIES \"" + links + '"';
+			}
+			result += " )\n";
+			result += "endif( )\n";
+			result += "set( " + package.name +
+			          "_INCLUDE_DIRS \"${_glean_install_prefix}/include\" )\n";
+			return result;
+		}
+
+		// The version is whatever glean checked out, any version asked for
+		// is accepted
+		constexpr char const package_version[] =
+		  "# Generated by glean\n"
+		  "set( PACKAGE_VERSION_COMPATIBLE TRUE )\n"
+		  "set( PACKAGE_VERSION_EXACT FALSE )\n";
+
+		// Write content to file unless it already has it, so that unchanged
+		// files keep their time stamps and dependents do not rebuild
+		void write_file( fs::path const &file, std::string const &content ) {
+			if( is_regular_file( file ) ) {
+				auto in = std::ifstream( file, std::ios::binary );
+				auto const old = std::string( std::istreambuf_iterator<char>( in ),
+				                              std::istreambuf_iterator<char>( ) );
+				if( old == content ) {
+					return;
+				}
+			}
+			fs::create_directories( file.parent_path( ) );
+			auto out = std::ofstream( file, std::ios::binary | std::ios::trunc );
+			out << content;
+		}
+
+		void install_file( fs::path const &from, fs::path const &to ) {
+			auto in = std::ifstream( from, std::ios::binary );
+			write_file( to, std::string( std::istreambuf_iterator<char>( in ),
+			                             std::istreambuf_iterator<char>( ) ) );
+		}
+	} // namespace
+
+	build_header_only::build_header_only( fs::path const &cache_path,
+	                                      fs::path const &install_prefix,
+	                                      glean_options const &, bool ) noexcept
+	  : m_cache_path( cache_path )
+	  , m_install_prefix( install_prefix ) {}
+
+	action_status build_header_only::build( daw::glean::build_types,
+	                                        glean_file_item const & ) const {
+		return action_status::success;
+	}
+
+	action_status
+	build_header_only::install( daw::glean::build_types bt,
+	                            glean_file_item const &file_dep ) const {
+		auto const include_folder = m_cache_path / "source" / "include";
+		if( not is_directory( include_folder ) ) {
+			log_error << "Header only dependency " << file_dep.provides
+			          << " has no include folder\n";
+			return action_status::failure;
+		}
+		auto const prefix = m_install_prefix / to_string( bt );
+		auto installed = std::vector<fs::path>( );
+		for( auto const &item :
+		     fs::recursive_directory_iterator( include_folder ) ) {
+			if( not is_regular_file( item.path( ) ) ) {
+				continue;
+			}
+			auto const to =
+			  prefix / "include" / item.path( ).lexically_relative( include_folder );
+			install_file( item.path( ), to );
+			installed.push_back( to );
+		}
+		auto const package = file_dep.cmake_package( );
+		auto const package_folder = prefix / "lib" / "cmake" / package.name;
+		auto const config = package_folder / ( package.name + "Config.cmake" );
+		write_file( config, package_config( file_dep.provides, package,
+		                                    file_dep.dependency_packages ) );
+		installed.push_back( config );
+		auto const version =
+		  package_folder / ( package.name + "ConfigVersion.cmake" );
+		write_file( version, package_version );
+		installed.push_back( version );
+
+		// Headers the source no longer has would still be found in the prefix
+		remove_stale_files( install_manifest( bt ), installed );
+		fs::create_directories( install_manifest( bt ).parent_path( ) );
+		auto manifest = std::ofstream( install_manifest( bt ), std::ios::trunc );
+		for( auto const &file : installed ) {
+			manifest << file.generic_string( ) << '\n';
+		}
+		log_message << "Installed " << std::to_string( installed.size( ) )
+		            << " files of header only " << file_dep.provides << '\n';
+		return to_action_status( static_cast<bool>( manifest ) );
+	}
+
+	std::vector<std::string>
+	build_header_only::build_inputs( daw::glean::build_types,
+	                                 glean_file_item const &file_dep ) const {
+		auto const package = file_dep.cmake_package( );
+		return {std::string( type_id.data( ), type_id.size( ) ), package.name,
+		        package.target};
+	}
+
+	bool build_header_only::is_installed( daw::glean::build_types bt ) const {
+		auto manifest = std::ifstream( install_manifest( bt ) );
+		if( not manifest ) {
+			return false;
+		}
+		auto line = std::string( );
+		while( std::getline( manifest, line ) ) {
+			if( not line.empty( ) and not exists( fs::path( line ) ) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	fs::path
+	build_header_only::install_manifest( daw::glean::build_types bt ) const {
+		return m_cache_path / "build" / to_string( bt ) / "install_manifest.txt";
+	}
+} // namespace daw::glean
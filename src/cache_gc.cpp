@@ -0,0 +1,469 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/cache_gc.h"
+#include "daw/glean/cache_lock.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		constexpr char const last_use_file_name[] = "glean_last_use";
+		constexpr char const build_time_extension[] = ".build_time";
+
+		// Recreate costs in seconds for what was never measured
+		constexpr std::int64_t unknown_build_seconds = 60;
+		constexpr std::uintmax_t clone_bytes_per_second = 8U * 1024U * 1024U;
+
+		[[nodiscard]] std::int64_t now_seconds( ) {
+			return std::chrono::duration_cast<std::chrono::seconds>(
+			         std::chrono::system_clock::now( ).time_since_epoch( ) )
+			  .count( );
+		}
+
+		[[nodiscard]] std::int64_t read_number( fs::path const &file ) {
+			auto in = std::ifstream( file );
+			auto result = std::int64_t( );
+			if( not( in >> result ) ) {
+				return 0;
+			}
+			return result;
+		}
+
+		void write_number( fs::path const &file, std::int64_t value ) {
+			auto out = std::ofstream( file, std::ios::trunc );
+			out << value << '\n';
+		}
+
+		[[nodiscard]] std::uintmax_t folder_size( fs::path const &folder ) {
+			auto result = std::uintmax_t( );
+			try {
+				for( auto const &item : fs::recursive_directory_iterator( folder ) ) {
+					if( is_regular_file( item.symlink_status( ) ) ) {
+						result += fs::file_size( item.path( ) );
+					}
+				}
+			} catch( std::exception const & ) {
+				// Another glean changed it while it was measured, close enough
+			}
+			return result;
+		}
+
+		[[nodiscard]] std::string format_size( std::uintmax_t size ) {
+			static constexpr char const *units[] = {"B", "KiB", "MiB", "GiB",
+			                                        "TiB"};
+			auto value = static_cast<double>( size );
+			size_t unit = 0;
+			while( value >= 1024.0 and unit + 1 < std::size( units ) ) {
+				value /= 1024.0;
+				++unit;
+			}
+			auto ss = std::stringstream( );
+			ss << std::fixed << std::setprecision( unit == 0 ? 0 : 1 ) << value
+			   << ' ' << units[unit];
+			return ss.str( );
+		}
+
+		// Entries are named by glean_file_item::cache_key, anything else is
+		// left over from the layout before it
+		[[nodiscard]] bool is_cache_key( std::string const &name ) {
+			return name.size( ) == 32U and
+			       std::all_of( name.begin( ), name.end( ), []( char c ) {
+				       return std::isxdigit( static_cast<unsigned char>( c ) ) != 0;
+			       } );
+		}
+
+		struct entry_t {
+			fs::path folder{};
+			std::int64_t last_use = 0;
+			std::uintmax_t source_size = 0;
+			std::uintmax_t build_size = 0;
+			std::int64_t build_seconds = 0;
+			bool is_mirror = false;
+			bool is_evicted = false;
+		};
+
+		[[nodiscard]] entry_t read_entry( fs::path const &folder ) {
+			auto result = entry_t{folder};
+			result.last_use = read_number( folder / last_use_file_name );
+			result.build_size = folder_size( folder / "build" );
+			result.source_size = folder_size( folder ) - result.build_size;
+			if( is_directory( folder / "build" ) ) {
+				for( auto const &item : fs::directory_iterator( folder / "build" ) ) {
+					if( item.path( ).extension( ) == build_time_extension ) {
+						result.build_seconds += read_number( item.path( ) );
+					}
+				}
+			}
+			return result;
+		}
+
+		// The name of the mirror that a source borrows its objects from.  Either
+		// through a worktree's gitdir file or an older shared clone's alternates
+		[[nodiscard]] std::optional<std::string>
+		mirror_of( fs::path const &source ) {
+			auto const git = source / ".git";
+			auto line = std::string( );
+			if( is_regular_file( git ) ) {
+				auto in = std::ifstream( git );
+				std::getline( in, line );
+				// gitdir: <mirror>/worktrees/<name>
+				auto const worktree =
+				  fs::path( trim( line.substr( line.find( ' ' ) + 1 ) ) );
+				return worktree.parent_path( ).parent_path( ).filename( ).string( );
+			}
+			auto in = std::ifstream( git / "objects" / "info" / "alternates" );
+			if( std::getline( in, line ) ) {
+				// <mirror>/objects
+				return fs::path( trim( line ) ).parent_path( ).filename( ).string( );
+			}
+			return std::nullopt;
+		}
+
+		// Seconds to recreate what evicting the entry's sources removes
+		[[nodiscard]] double source_cost( entry_t const &entry ) {
+			auto result = static_cast<double>( entry.source_size ) /
+			              static_cast<double>( clone_bytes_per_second );
+			if( entry.build_size > 0 ) {
+				result += static_cast<double>( entry.build_seconds > 0
+				                                 ? entry.build_seconds
+				                                 : unknown_build_seconds );
+			}
+			return std::max( result, 1.0 );
+		}
+
+		[[nodiscard]] double build_cost( entry_t const &entry ) {
+			return static_cast<double>(
+			  std::max<std::int64_t>( entry.build_seconds > 0
+			                            ? entry.build_seconds
+			                            : unknown_build_seconds,
+			                          1 ) );
+		}
+
+		// Old and cheap to recreate scores highest
+		template<typename Cost>
+		void sort_by_score( std::vector<entry_t *> &entries, Cost cost ) {
+			auto const now = now_seconds( );
+			auto const score = [&]( entry_t const *entry ) {
+				auto const age = std::max<std::int64_t>( now - entry->last_use, 1 );
+				return static_cast<double>( age ) / cost( *entry );
+			};
+			std::stable_sort( entries.begin( ), entries.end( ),
+			                  [&]( entry_t const *lhs, entry_t const *rhs ) {
+				                  return score( lhs ) > score( rhs );
+			                  } );
+		}
+
+		// Only the lock is left once a folder has been removed
+		[[nodiscard]] bool is_removed( fs::path const &folder ) {
+			for( auto const &item : fs::directory_iterator( folder ) ) {
+				if( item.path( ) != source_lock_file( folder ) ) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Folders below <cache>/<provides>/ that are not cache entries, left by
+		// the layout before cache keys
+		[[nodiscard]] std::vector<fs::path>
+		legacy_folders( fs::path const &cache_root ) {
+			auto result = std::vector<fs::path>( );
+			for( auto const &provides : fs::directory_iterator( cache_root ) ) {
+				auto const name = provides.path( ).filename( ).string( );
+				if( not is_directory( provides.path( ) ) or name.front( ) == '.' ) {
+					continue;
+				}
+				for( auto const &item : fs::directory_iterator( provides.path( ) ) ) {
+					if( is_directory( item.path( ) ) and
+					    not is_cache_key( item.path( ).filename( ).string( ) ) and
+					    not is_removed( item.path( ) ) ) {
+						result.push_back( item.path( ) );
+					}
+				}
+			}
+			return result;
+		}
+
+		[[nodiscard]] bool remove_folder( fs::path const &folder ) {
+			try {
+				fs::remove_all( folder );
+				return true;
+			} catch( std::exception const &ex ) {
+				log_message << "Could not remove " << folder << ": " << ex.what( )
+				            << '\n';
+				return false;
+			}
+		}
+
+		// Everything in folder but its source lock.  Removing a held lock file
+		// would leave a waiting process locking an unlinked file while another
+		// creates a new one and locks that too
+		[[nodiscard]] bool remove_all_but_lock( fs::path const &folder ) {
+			auto const lock_file = source_lock_file( folder );
+			try {
+				for( auto const &item : fs::directory_iterator( folder ) ) {
+					if( item.path( ) != lock_file ) {
+						fs::remove_all( item.path( ) );
+					}
+				}
+				return true;
+			} catch( std::exception const &ex ) {
+				log_message << "Could not remove " << folder << ": " << ex.what( )
+				            << '\n';
+				return false;
+			}
+		}
+	} // namespace
+
+	void mark_cache_used( fs::path const &folder ) {
+		write_number( folder / last_use_file_name, now_seconds( ) );
+	}
+
+	void record_build_time( fs::path const &cache_folder,
+	                        std::string const &build_name,
+	                        std::chrono::seconds duration ) {
+		write_number( cache_folder / "build" /
+		                ( build_name + build_time_extension ),
+		              duration.count( ) );
+	}
+
+	std::optional<std::uintmax_t> parse_size( std::string_view str ) {
+		size_t pos = 0;
+		auto result = std::uintmax_t( );
+		while( pos < str.size( ) and
+		       std::isdigit( static_cast<unsigned char>( str[pos] ) ) != 0 ) {
+			result = result * 10U + static_cast<std::uintmax_t>( str[pos] - '0' );
+			++pos;
+		}
+		if( pos == 0 ) {
+			return std::nullopt;
+		}
+		auto suffix = std::string( str.substr( pos ) );
+		for( char &c : suffix ) {
+			c = static_cast<char>( std::toupper( static_cast<unsigned char>( c ) ) );
+		}
+		if( suffix.empty( ) or suffix == "B" ) {
+			return result;
+		}
+		static constexpr std::string_view units = "KMGT";
+		auto const unit = units.find( suffix.front( ) );
+		if( unit == std::string_view::npos or
+		    ( suffix.size( ) > 1 and suffix.substr( 1 ) != "B" and
+		      suffix.substr( 1 ) != "IB" ) ) {
+			return std::nullopt;
+		}
+		for( size_t n = 0; n <= unit; ++n ) {
+			result *= 1024U;
+		}
+		return result;
+	}
+
+	action_status
+	collect_cache_garbage( fs::path const &cache_root,
+	                       std::optional<std::uintmax_t> size_limit ) {
+		if( not is_directory( cache_root ) ) {
+			log_error << "Cache folder " << cache_root << " does not exist\n";
+			return action_status::failure;
+		}
+		auto entries = std::vector<entry_t>( );
+		auto freed = std::uintmax_t( );
+		for( auto const &provides : fs::directory_iterator( cache_root ) ) {
+			auto const name = provides.path( ).filename( ).string( );
+			if( not is_directory( provides.path( ) ) or name.front( ) == '.' ) {
+				continue;
+			}
+			for( auto const &item : fs::directory_iterator( provides.path( ) ) ) {
+				if( is_directory( item.path( ) ) and
+				    is_cache_key( item.path( ).filename( ).string( ) ) ) {
+					entries.push_back( read_entry( item.path( ) ) );
+				}
+			}
+		}
+		// Counted against the budget but only removed by migrate_cache
+		auto const legacy = legacy_folders( cache_root );
+		auto legacy_size = std::uintmax_t( );
+		for( auto const &folder : legacy ) {
+			legacy_size += folder_size( folder );
+		}
+		auto referenced_mirrors = std::unordered_set<std::string>( );
+		for( entry_t const &entry : entries ) {
+			if( auto mirror = mirror_of( entry.folder / "source" ); mirror ) {
+				referenced_mirrors.insert( *mirror );
+			}
+		}
+		auto const mirrors_root = cache_root / ".git_mirrors";
+		if( is_directory( mirrors_root ) ) {
+			for( auto const &item : fs::directory_iterator( mirrors_root ) ) {
+				if( not is_directory( item.path( ) ) ) {
+					continue;
+				}
+				auto mirror = entry_t{item.path( )};
+				mirror.last_use = read_number( item.path( ) / last_use_file_name );
+				mirror.source_size = folder_size( item.path( ) );
+				mirror.is_mirror = true;
+				entries.push_back( std::move( mirror ) );
+			}
+		}
+
+		auto total = legacy_size;
+		for( entry_t const &entry : entries ) {
+			total += entry.source_size + entry.build_size;
+		}
+		auto const over_budget = [&] {
+			return size_limit and total > *size_limit;
+		};
+		size_t evicted_builds = 0;
+		size_t evicted_sources = 0;
+
+		// Builds first, they are recreated from the sources
+		auto candidates = std::vector<entry_t *>( );
+		for( entry_t &entry : entries ) {
+			if( not entry.is_mirror and entry.build_size > 0 ) {
+				candidates.push_back( &entry );
+			}
+		}
+		sort_by_score( candidates, build_cost );
+		for( entry_t *entry : candidates ) {
+			if( not over_budget( ) ) {
+				break;
+			}
+			auto const lck = cache_lock( source_lock_file( entry->folder ),
+			                             lock_modes::exclusive, false );
+			if( not lck.owns_lock( ) ) {
+				continue;
+			}
+			log_message << "Evicting build " << ( entry->folder / "build" )
+			            << '\n';
+			if( remove_folder( entry->folder / "build" ) ) {
+				fs::create_directories( entry->folder / "build" );
+				total -= entry->build_size;
+				freed += entry->build_size;
+				entry->build_size = 0;
+				++evicted_builds;
+			}
+		}
+
+		candidates.clear( );
+		for( entry_t &entry : entries ) {
+			if( not entry.is_mirror or
+			    referenced_mirrors.count(
+			      entry.folder.filename( ).string( ) ) == 0 ) {
+				candidates.push_back( &entry );
+			}
+		}
+		sort_by_score( candidates, source_cost );
+		for( entry_t *entry : candidates ) {
+			if( not over_budget( ) ) {
+				break;
+			}
+			auto const lock_file = entry->is_mirror
+			                         ? mirror_lock_file( entry->folder )
+			                         : source_lock_file( entry->folder );
+			auto const lck = cache_lock( lock_file, lock_modes::exclusive, false );
+			if( not lck.owns_lock( ) ) {
+				continue;
+			}
+			log_message << "Evicting " << entry->folder << '\n';
+			// The lock files are kept, others may be waiting on them
+			auto const removed = entry->is_mirror
+			                       ? remove_folder( entry->folder )
+			                       : remove_all_but_lock( entry->folder );
+			if( removed ) {
+				auto const size = entry->source_size + entry->build_size;
+				total -= size;
+				freed += size;
+				++evicted_sources;
+			}
+		}
+
+		for( auto const &provides : fs::directory_iterator( cache_root ) ) {
+			auto const name = provides.path( ).filename( ).string( );
+			if( is_directory( provides.path( ) ) and name.front( ) != '.' and
+			    fs::is_empty( provides.path( ) ) ) {
+				(void)remove_folder( provides.path( ) );
+			}
+		}
+
+		log_message << "Cache " << cache_root << ": evicted "
+		            << std::to_string( evicted_builds ) << " builds and "
+		            << std::to_string( evicted_sources ) << " sources, freed "
+		            << format_size( freed ) << ", now " << format_size( total );
+		if( size_limit ) {
+			log_message << " of " << format_size( *size_limit );
+		}
+		log_message << '\n';
+		if( not legacy.empty( ) ) {
+			log_message << std::to_string( legacy.size( ) )
+			            << " folders from an older version of glean use "
+			            << format_size( legacy_size )
+			            << ", 'glean cache migrate' removes them\n";
+		}
+		if( over_budget( ) ) {
+			log_message << "The cache is still over its limit, the rest is in use\n";
+		}
+		return action_status::success;
+	}
+
+	action_status migrate_cache( fs::path const &cache_root ) {
+		if( not is_directory( cache_root ) ) {
+			log_error << "Cache folder " << cache_root << " does not exist\n";
+			return action_status::failure;
+		}
+		auto freed = std::uintmax_t( );
+		auto result = action_status::success;
+		for( auto const &folder : legacy_folders( cache_root ) ) {
+			auto const lck = cache_lock( source_lock_file( folder ),
+			                             lock_modes::exclusive, false );
+			if( not lck.owns_lock( ) ) {
+				log_message << "Skipping " << folder << ", it is in use\n";
+				result = action_status::failure;
+				continue;
+			}
+			auto const size = folder_size( folder );
+			log_message << "Removing " << folder
+			            << ", it is from an older version of glean\n";
+			if( remove_all_but_lock( folder ) ) {
+				freed += size;
+			} else {
+				result = action_status::failure;
+			}
+		}
+		log_message << "Cache " << cache_root << ": freed " << format_size( freed )
+		            << " left by older versions of glean\n";
+		return result;
+	}
+} // namespace daw::glean
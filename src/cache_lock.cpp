@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include "daw/glean/cache_lock.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	cache_lock::cache_lock( fs::path const &lock_file, lock_modes mode,
+	                        bool wait ) {
+#ifdef _WIN32
+		m_handle = CreateFileW( lock_file.wstring( ).c_str( ),
+		                        GENERIC_READ | GENERIC_WRITE,
+		                        FILE_SHARE_READ | FILE_SHARE_WRITE |
+		                          FILE_SHARE_DELETE,
+		                        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+		                        nullptr );
+		if( m_handle == INVALID_HANDLE_VALUE ) {
+			m_handle = nullptr;
+			log_error << "Could not open lock file " << lock_file << '\n';
+			exit( EXIT_FAILURE );
+		}
+		DWORD const flags =
+		  mode == lock_modes::exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0;
+		auto overlapped = OVERLAPPED{};
+		if( LockFileEx( m_handle, flags | LOCKFILE_FAIL_IMMEDIATELY, 0, MAXDWORD,
+		                MAXDWORD, &overlapped ) ) {
+			return;
+		}
+		if( not wait and GetLastError( ) == ERROR_LOCK_VIOLATION ) {
+			m_owns_lock = false;
+			return;
+		}
+		log_message << "Waiting for another glean using " << lock_file << '\n';
+		overlapped = OVERLAPPED{};
+		if( not LockFileEx( m_handle, flags, 0, MAXDWORD, MAXDWORD,
+		                    &overlapped ) ) {
+			log_message << "Could not lock " << lock_file
+			            << ", continuing without it\n";
+		}
+#else
+		m_fd = ::open( lock_file.c_str( ), O_RDWR | O_CREAT | O_CLOEXEC, 0666 );
+		if( m_fd < 0 ) {
+			log_error << "Could not open lock file " << lock_file << ": "
+			          << std::strerror( errno ) << '\n';
+			exit( EXIT_FAILURE );
+		}
+		int const operation = mode == lock_modes::exclusive ? LOCK_EX : LOCK_SH;
+		if( ::flock( m_fd, operation | LOCK_NB ) == 0 ) {
+			return;
+		}
+		if( errno == EWOULDBLOCK and not wait ) {
+			m_owns_lock = false;
+			return;
+		}
+		if( errno == EWOULDBLOCK ) {
+			log_message << "Waiting for another glean using " << lock_file << '\n';
+			int result = 0;
+			do {
+				result = ::flock( m_fd, operation );
+			} while( result != 0 and errno == EINTR );
+			if( result == 0 ) {
+				return;
+			}
+		}
+		// Some network filesystems have no locks, they are advisory anyway
+		log_message << "Could not lock " << lock_file << ": "
+		            << std::strerror( errno ) << ", continuing without it\n";
+#endif
+	}
+
+	cache_lock::~cache_lock( ) {
+#ifdef _WIN32
+		if( m_handle != nullptr ) {
+			// Closing the handle releases the lock
+			CloseHandle( m_handle );
+		}
+#else
+		if( m_fd >= 0 ) {
+			// Closing the descriptor releases the lock
+			::close( m_fd );
+		}
+#endif
+	}
+
+	bool cache_lock::owns_lock( ) const noexcept {
+		return m_owns_lock;
+	}
+} // namespace daw::glean
@@ -32,22 +32,50 @@
 #include "daw/glean/utilities.h"
 
 namespace daw::glean {
+	std::string cmake_config_name( daw::glean::build_types bt ) {
+		if( bt == daw::glean::build_types::debug ) {
+			return "Debug";
+		}
+		return "Release";
+	}
+
 	std::vector<std::string>
 	cmake_action_configure::build_args( fs::path build_path,
 	                                    daw::glean::build_types bt ) const {
 
+		auto const prefix =
+		  install_prefix /
+		  to_string( multi_config ? daw::glean::build_types::release : bt );
 		auto result = std::vector<std::string>( );
-		result.push_back( daw::fmt_t( "-DCMAKE_INSTALL_PREFIX:PATH={0}" )(
-		  ( install_prefix / to_string( bt ) ).string( ) ) );
+		result.push_back(
+		  daw::fmt_t( "-DCMAKE_INSTALL_PREFIX:PATH={0}" )( prefix.string( ) ) );
 
 		if( has_glean ) {
-			result.push_back( daw::fmt_t( "-DGLEAN_INSTALL_ROOT={0}" )(
-			  ( install_prefix / to_string( bt ) ).string( ) ) );
+			result.push_back(
+			  daw::fmt_t( "-DGLEAN_INSTALL_ROOT={0}" )( prefix.string( ) ) );
 		}
 		result.push_back( "-S" );
 		result.push_back( source_path.string( ) );
 		result.push_back( "-B" );
-		result.push_back( ( build_path / to_string( bt ) ).string( ) );
+		if( multi_config ) {
+			result.push_back( ( build_path / multi_config_folder ).string( ) );
+			result.push_back( "-G" );
+			result.push_back( "Ninja Multi-Config" );
+			result.push_back( daw::fmt_t( "-DCMAKE_CONFIGURATION_TYPES={0};{1}" )(
+			  cmake_config_name( daw::glean::build_types::debug ),
+			  cmake_config_name( daw::glean::build_types::release ) ) );
+		} else {
+			result.push_back( ( build_path / to_string( bt ) ).string( ) );
+		}
+
+		// Before the custom arguments so that a dependency can override it
+		if( not compiler_launcher.empty( ) ) {
+			for( char const *lang : {"C", "CXX"} ) {
+				result.push_back(
+				  daw::fmt_t( "-DCMAKE_{0}_COMPILER_LAUNCHER={1}" )(
+				    lang, compiler_launcher.string( ) ) );
+			}
+		}
 
 		result.insert( result.cend( ), custom_arguments.cbegin( ),
 		               custom_arguments.cend( ) );
@@ -66,14 +94,61 @@ namespace daw::glean {
 	cmake_action_build::build_args( fs::path build_path,
 	                                daw::glean::build_types bt ) const {
 
-		return {"--build", ( build_path / to_string( bt ) ).string( ), "--parallel",
-		        std::to_string( jobs )};
+		auto result = std::vector<std::string>{"--build"};
+		if( multi_config ) {
+			result.push_back( ( build_path / multi_config_folder ).string( ) );
+			result.push_back( "--config" );
+			result.push_back( cmake_config_name( bt ) );
+		} else {
+			result.push_back( ( build_path / to_string( bt ) ).string( ) );
+		}
+		if( not use_jobserver ) {
+			result.push_back( "--parallel" );
+			result.push_back( std::to_string( jobs ) );
+		}
+		return result;
 	}
 
 	std::vector<std::string>
 	cmake_action_install::build_args( fs::path build_path,
 	                                  daw::glean::build_types bt ) const {
-		return {"--build", ( build_path / to_string( bt ) ).string( ), "--target",
-		        "install"};
+		auto result = std::vector<std::string>{
+		  "--build", ( build_path / to_string( bt ) ).string( ), "--target",
+		  "install"};
+		if( jobs > 0 and not use_jobserver ) {
+			result.push_back( "--parallel" );
+			result.push_back( std::to_string( jobs ) );
+		}
+		return result;
+	}
+
+	std::vector<std::string>
+	cmake_action_install_config::build_args( fs::path build_path,
+	                                         daw::glean::build_types bt ) const {
+		return {"--install",
+		        ( build_path / multi_config_folder ).string( ),
+		        "--config",
+		        cmake_config_name( bt ),
+		        "--prefix",
+		        ( install_prefix / to_string( bt ) ).string( )};
+	}
+
+	std::vector<std::string>
+	cmake_action_tar_create::build_args( fs::path,
+	                                     daw::glean::build_types ) const {
+		return {"-E", "tar", "cfz", archive.string( ),
+		        "--files-from=" + file_list.string( )};
+	}
+
+	std::vector<std::string>
+	cmake_action_tar_extract::build_args( fs::path,
+	                                      daw::glean::build_types ) const {
+		return {"-E", "tar", "xfz", archive.string( )};
+	}
+
+	std::vector<std::string>
+	cmake_action_tar_list::build_args( fs::path,
+	                                   daw::glean::build_types ) const {
+		return {"-E", "tar", "tf", archive.string( )};
 	}
 } // namespace daw::glean
@@ -0,0 +1,223 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <boost/process/search_path.hpp>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "daw/glean/cache_gc.h"
+#include "daw/glean/compiler_cache.h"
+#include "daw/glean/glean_config.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/proc.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		constexpr char const default_size_limit[] = "5G";
+
+		// Searched for, in order, when the config does not name a launcher
+		constexpr char const *const known_launchers[] = {"ccache", "sccache"};
+
+		[[nodiscard]] std::string launcher_name( fs::path const &launcher ) {
+			return launcher.stem( ).string( );
+		}
+
+		[[nodiscard]] bool is_known_launcher( fs::path const &launcher ) {
+			for( char const *name : known_launchers ) {
+				if( launcher_name( launcher ) == name ) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// The counters of a statistics listing, lines that end in a number.
+		// ccache --print-stats separates them with a tab, --show-stats of
+		// sccache and older ccache with spaces
+		[[nodiscard]] std::map<std::string, std::int64_t>
+		parse_statistics( std::string const &listing ) {
+			auto result = std::map<std::string, std::int64_t>( );
+			auto lines = std::istringstream( listing );
+			auto line = std::string( );
+			while( std::getline( lines, line ) ) {
+				line = trim( line );
+				auto const pos = line.find_last_of( " \t" );
+				if( pos == std::string::npos ) {
+					continue;
+				}
+				auto const value = line.substr( pos + 1 );
+				auto const name = trim( line.substr( 0, pos ) );
+				if( value.empty( ) or name.empty( ) or
+				    not std::all_of( value.begin( ), value.end( ), []( char c ) {
+					    return std::isdigit( static_cast<unsigned char>( c ) ) != 0;
+				    } ) ) {
+					continue;
+				}
+				// Times, not counts
+				if( name.find( "timestamp" ) != std::string::npos ) {
+					continue;
+				}
+				result[name] = std::stoll( value );
+			}
+			return result;
+		}
+
+		[[nodiscard]] fs::path find_launcher( std::string const &name ) {
+			if( fs::path( name ).has_parent_path( ) ) {
+				return exists( fs::path( name ) ) ? fs::path( name ) : fs::path( );
+			}
+			return fs::path( boost::process::search_path( name ).string( ) );
+		}
+	} // namespace
+
+	compiler_cache::compiler_cache( fs::path launcher,
+	                                fs::path const &cache_root,
+	                                std::uintmax_t size_limit )
+	  : m_launcher( std::move( launcher ) )
+	  , m_folder( cache_root / ".compiler_cache" / launcher_name( m_launcher ) )
+	  // Both read a plain number as a different unit, but agree on K
+	  , m_size_limit( std::to_string( size_limit / 1024U ) + 'K' ) {
+		if( launcher_name( m_launcher ) == "ccache" ) {
+			m_size_limit += 'i';
+		}
+	}
+
+	fs::path const &compiler_cache::launcher( ) const noexcept {
+		return m_launcher;
+	}
+
+	void compiler_cache::set_base_dir( fs::path base_dir ) {
+		m_base_dir = std::move( base_dir );
+	}
+
+	std::vector<std::pair<std::string, std::string>>
+	compiler_cache::environment( ) const {
+		auto const name = launcher_name( m_launcher );
+		if( name == "ccache" ) {
+			auto result = std::vector<std::pair<std::string, std::string>>{
+			  {"CCACHE_DIR", m_folder.string( )}, {"CCACHE_MAXSIZE", m_size_limit}};
+			if( not m_base_dir.empty( ) ) {
+				result.emplace_back( "CCACHE_BASEDIR", m_base_dir.string( ) );
+			}
+			return result;
+		}
+		if( name == "sccache" ) {
+			return {{"SCCACHE_DIR", m_folder.string( )},
+			        {"SCCACHE_CACHE_SIZE", m_size_limit}};
+		}
+		// Other launchers keep their own configuration
+		return {};
+	}
+
+	std::map<std::string, std::int64_t> compiler_cache::statistics( ) const {
+		if( not is_known_launcher( m_launcher ) ) {
+			return {};
+		}
+		auto opts = process_options( );
+		opts.environment = environment( );
+		if( launcher_name( m_launcher ) == "ccache" ) {
+			auto const result =
+			  run_process( m_launcher.string( ), {"--print-stats"}, opts );
+			if( result.exit_code == EXIT_SUCCESS ) {
+				return parse_statistics( result.output );
+			}
+		}
+		auto const result =
+		  run_process( m_launcher.string( ), {"--show-stats"}, opts );
+		if( result.exit_code != EXIT_SUCCESS ) {
+			return {};
+		}
+		return parse_statistics( result.output );
+	}
+
+	void compiler_cache::snapshot_statistics( ) {
+		m_start_statistics = statistics( );
+	}
+
+	void compiler_cache::log_statistics( ) const {
+		if( not is_known_launcher( m_launcher ) ) {
+			return;
+		}
+		auto const end = statistics( );
+		if( end.empty( ) ) {
+			return;
+		}
+		log_message << "\nCompiler cache (" << launcher_name( m_launcher )
+		            << ") statistics for this run:\n";
+		bool has_changes = false;
+		for( auto const &[name, value] : end ) {
+			auto const pos = m_start_statistics.find( name );
+			auto const delta =
+			  value - ( pos == m_start_statistics.end( ) ? 0 : pos->second );
+			if( delta == 0 ) {
+				continue;
+			}
+			log_message << "  " << name << ": " << std::to_string( delta ) << '\n';
+			has_changes = true;
+		}
+		if( not has_changes ) {
+			log_message << "  nothing was compiled\n";
+		}
+	}
+
+	std::optional<compiler_cache>
+	find_compiler_cache( glean_config const &config,
+	                     fs::path const &cache_root ) {
+		auto launcher = fs::path( );
+		if( config.compiler_launcher.empty( ) ) {
+			for( char const *name : known_launchers ) {
+				launcher = find_launcher( name );
+				if( not launcher.empty( ) ) {
+					break;
+				}
+			}
+		} else if( config.compiler_launcher != "none" ) {
+			launcher = find_launcher( config.compiler_launcher );
+			if( launcher.empty( ) ) {
+				log_error << "Could not find the compiler launcher '"
+				          << config.compiler_launcher << "'\n";
+				exit( EXIT_FAILURE );
+			}
+		}
+		if( launcher.empty( ) ) {
+			return std::nullopt;
+		}
+		auto const &limit = config.compiler_cache_size_limit.empty( )
+		                      ? std::string( default_size_limit )
+		                      : config.compiler_cache_size_limit;
+		auto const size_limit = parse_size( limit );
+		if( not size_limit ) {
+			log_error << "Invalid compiler cache size limit '" << limit << "'\n";
+			exit( EXIT_FAILURE );
+		}
+		return compiler_cache( std::move( launcher ), cache_root, *size_limit );
+	}
+} // namespace daw::glean
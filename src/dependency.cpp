@@ -61,8 +61,28 @@ namespace daw::glean {
 		return alt( ).build_type.build( bt, *( alt( ).file_dep ) );
 	}
 
-	action_status dependency::install( daw::glean::build_types bt ) const {
-		return alt( ).build_type.install( bt );
+	action_status dependency::install(
+	  daw::glean::build_types bt,
+	  std::vector<cmake_package_t> dependency_packages ) const {
+		assert( alt( ).file_dep );
+		auto file_dep = *( alt( ).file_dep );
+		file_dep.dependency_packages = std::move( dependency_packages );
+		return alt( ).build_type.install( bt, file_dep );
+	}
+
+	std::vector<std::string>
+	dependency::build_inputs( daw::glean::build_types bt ) const {
+		assert( alt( ).file_dep );
+		return alt( ).build_type.build_inputs( bt, *( alt( ).file_dep ) );
+	}
+
+	bool dependency::is_installed( daw::glean::build_types bt ) const {
+		return alt( ).build_type.is_installed( bt );
+	}
+
+	fs::path
+	dependency::install_manifest( daw::glean::build_types bt ) const {
+		return alt( ).build_type.install_manifest( bt );
 	}
 
 	bool dependency::has_file_dep( ) const noexcept {
@@ -0,0 +1,159 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "daw/glean/digest.h"
+
+namespace daw::glean {
+	namespace {
+		constexpr std::array<uint32_t, 64> round_constants = {
+		  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+		  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+		  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+		  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+		  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+		  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+		  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+		  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+		  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+		[[nodiscard]] constexpr uint32_t rotr( uint32_t value,
+		                                       uint32_t count ) noexcept {
+			return ( value >> count ) | ( value << ( 32U - count ) );
+		}
+	} // namespace
+
+	sha256::sha256( ) noexcept
+	  : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+	void sha256::process_block( ) {
+		auto w = std::array<uint32_t, 64>{};
+		for( size_t n = 0; n < 16; ++n ) {
+			w[n] = ( static_cast<uint32_t>( m_block[n * 4] ) << 24U ) |
+			       ( static_cast<uint32_t>( m_block[n * 4 + 1] ) << 16U ) |
+			       ( static_cast<uint32_t>( m_block[n * 4 + 2] ) << 8U ) |
+			       static_cast<uint32_t>( m_block[n * 4 + 3] );
+		}
+		for( size_t n = 16; n < 64; ++n ) {
+			auto const s0 =
+			  rotr( w[n - 15], 7 ) ^ rotr( w[n - 15], 18 ) ^ ( w[n - 15] >> 3U );
+			auto const s1 =
+			  rotr( w[n - 2], 17 ) ^ rotr( w[n - 2], 19 ) ^ ( w[n - 2] >> 10U );
+			w[n] = w[n - 16] + s0 + w[n - 7] + s1;
+		}
+		auto s = m_state;
+		for( size_t n = 0; n < 64; ++n ) {
+			auto const e1 = rotr( s[4], 6 ) ^ rotr( s[4], 11 ) ^ rotr( s[4], 25 );
+			auto const ch = ( s[4] & s[5] ) ^ ( ~s[4] & s[6] );
+			auto const t1 = s[7] + e1 + ch + round_constants[n] + w[n];
+			auto const e0 = rotr( s[0], 2 ) ^ rotr( s[0], 13 ) ^ rotr( s[0], 22 );
+			auto const maj = ( s[0] & s[1] ) ^ ( s[0] & s[2] ) ^ ( s[1] & s[2] );
+			auto const t2 = e0 + maj;
+			s[7] = s[6];
+			s[6] = s[5];
+			s[5] = s[4];
+			s[4] = s[3] + t1;
+			s[3] = s[2];
+			s[2] = s[1];
+			s[1] = s[0];
+			s[0] = t1 + t2;
+		}
+		for( size_t n = 0; n < 8; ++n ) {
+			m_state[n] += s[n];
+		}
+		m_block_size = 0;
+	}
+
+	sha256 &sha256::update( std::string_view data ) {
+		m_total_size += data.size( );
+		for( char c : data ) {
+			m_block[m_block_size++] = static_cast<unsigned char>( c );
+			if( m_block_size == m_block.size( ) ) {
+				process_block( );
+			}
+		}
+		return *this;
+	}
+
+	sha256 &sha256::update_field( std::string_view data ) {
+		update( data );
+		return update( std::string_view( "\0", 1 ) );
+	}
+
+	std::string sha256::hex_digest( ) {
+		uint64_t const bit_size = m_total_size * 8U;
+		m_block[m_block_size++] = 0x80;
+		if( m_block_size > 56 ) {
+			while( m_block_size < m_block.size( ) ) {
+				m_block[m_block_size++] = 0;
+			}
+			process_block( );
+		}
+		while( m_block_size < 56 ) {
+			m_block[m_block_size++] = 0;
+		}
+		for( size_t n = 0; n < 8; ++n ) {
+			m_block[56 + n] =
+			  static_cast<unsigned char>( bit_size >> ( 56U - 8U * n ) );
+		}
+		process_block( );
+
+		constexpr char const hex_digits[] = "0123456789abcdef";
+		auto result = std::string( );
+		result.reserve( 64 );
+		for( uint32_t word : m_state ) {
+			for( int shift = 28; shift >= 0; shift -= 4 ) {
+				result.push_back( hex_digits[( word >> shift ) & 0xFU] );
+			}
+		}
+		return result;
+	}
+
+	std::string sha256_hex( std::string_view data ) {
+		return sha256( ).update( data ).hex_digest( );
+	}
+
+	std::string sha256_file_hex( fs::path const &file ) {
+		auto in = std::ifstream( file, std::ios::binary );
+		if( not in ) {
+			return {};
+		}
+		auto digest = sha256( );
+		auto buffer = std::string( 64U * 1024U, '\0' );
+		while( in.read( buffer.data( ), buffer.size( ) ) or in.gcount( ) > 0 ) {
+			digest.update( std::string_view( buffer.data( ),
+			                                 static_cast<size_t>( in.gcount( ) ) ) );
+		}
+		if( in.bad( ) ) {
+			return {};
+		}
+		return digest.hex_digest( );
+	}
+} // namespace daw::glean
@@ -20,12 +20,25 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "daw/glean/action_status.h"
+#include "daw/glean/cache_gc.h"
+#include "daw/glean/cache_lock.h"
+#include "daw/glean/digest.h"
 #include "daw/glean/download_git.h"
 #include "daw/glean/git_helper.h"
+#include "daw/glean/glean_options.h"
 #include "daw/glean/logging.h"
 #include "daw/glean/proc.h"
 #include "daw/glean/utilities.h"
@@ -33,63 +46,490 @@
 namespace daw::glean {
 	namespace {
 		[[nodiscard]] bool is_git_repos( fs::path const &repos ) {
-			return is_directory( repos / ".git" );
+			return exists( repos / ".git" );
 		}
 
-		[[nodiscard]] action_status
-		git_repos_checkout( fs::path const &repos, std::string const &version ) {
-			auto const chdir = change_directory( repos );
-			auto result = git_runner( git_action_reset( ), repos, log_message );
-			if( result == action_status::success ) {
-				if( version.empty( ) ) {
-					result =
-					  git_runner( git_action_version{"master"}, repos, log_message );
+		// A working tree of the mirror, its .git is a file naming the
+		// mirror's administrative folder for it
+		[[nodiscard]] bool is_worktree( fs::path const &repos ) {
+			return is_regular_file( repos / ".git" );
+		}
+
+		[[nodiscard]] fs::path git_folder( fs::path const &repos ) {
+			if( not is_worktree( repos ) ) {
+				return repos / ".git";
+			}
+			auto git_file = std::ifstream( repos / ".git" );
+			auto line = std::string( );
+			std::getline( git_file, line );
+			auto const prefix = std::string( "gitdir: " );
+			if( line.rfind( prefix, 0 ) != 0 ) {
+				return repos / ".git";
+			}
+			auto result = fs::path( trim( line.substr( prefix.size( ) ) ) );
+			if( result.is_relative( ) ) {
+				result = repos / result;
+			}
+			return result;
+		}
+
+		[[nodiscard]] bool is_shallow_repos( fs::path const &repos ) {
+			return exists( git_folder( repos ) / "shallow" );
+		}
+
+		// A checked out tag or commit has nothing to pull
+		[[nodiscard]] bool is_detached_head( fs::path const &repos ) {
+			auto head = std::ifstream( git_folder( repos ) / "HEAD" );
+			auto line = std::string( );
+			std::getline( head, line );
+			return line.rfind( "ref: ", 0 ) != 0;
+		}
+
+		enum class remote_ref_kinds { branch, tag, other };
+
+		// What version names on the remote, other is most likely a commit
+		[[nodiscard]] remote_ref_kinds
+		remote_ref_kind( std::string const &remote, std::string const &version,
+		                 fs::path const &folder ) {
+			auto refs = std::string( );
+			auto ls_remote = git_action_ls_remote{remote, version};
+			if( not to_bool( git_runner( ls_remote, folder, in_folder( folder ),
+			                             std::back_inserter( refs ) ) ) ) {
+				return remote_ref_kinds::other;
+			}
+			if( refs.find( "\trefs/heads/" + version + '\n' ) != std::string::npos ) {
+				return remote_ref_kinds::branch;
+			}
+			if( refs.find( "\trefs/tags/" + version + '\n' ) != std::string::npos ) {
+				return remote_ref_kinds::tag;
+			}
+			return remote_ref_kinds::other;
+		}
+
+		[[nodiscard]] bool has_version( fs::path const &repos,
+		                                std::string const &version ) {
+			auto const has_rev = [&]( std::string rev ) {
+				auto out = std::string( );
+				return to_bool( git_runner( git_action_rev_parse{rev + "^{commit}"},
+				                            repos, in_folder( repos ),
+				                            std::back_inserter( out ) ) );
+			};
+			return has_rev( version ) or has_rev( "origin/" + version );
+		}
+
+		// Shallow, single branch and older clones may not have version yet.
+		// Fetch only what it names and fall back to the whole history
+		[[nodiscard]] action_status git_repos_fetch( fs::path const &repos,
+		                                             std::string const &version ) {
+			log_message << "fetching '" << version << "' into '" << repos << "'\n";
+			auto fetch = git_action_fetch{};
+			fetch.is_shallow = is_shallow_repos( repos );
+			switch( remote_ref_kind( "origin", version, repos ) ) {
+			case remote_ref_kinds::branch:
+				if( not to_bool( git_runner( git_action_track_branch{version}, repos,
+				                             in_folder( repos ), log_message ) ) ) {
+					return action_status::failure;
+				}
+				fetch.refspecs.push_back( "+refs/heads/" + version +
+				                          ":refs/remotes/origin/" + version );
+				break;
+			case remote_ref_kinds::tag:
+				fetch.refspecs.push_back( "+refs/tags/" + version + ":refs/tags/" +
+				                          version );
+				break;
+			case remote_ref_kinds::other:
+				// Servers only hand out commits by their full hash
+				fetch.refspecs.push_back( version );
+				break;
+			}
+			if( to_bool( git_runner( fetch, repos, in_folder( repos ),
+			                         log_message ) ) and
+			    has_version( repos, version ) ) {
+				return action_status::success;
+			}
+			auto fetch_all = git_action_fetch{};
+			fetch_all.unshallow = is_shallow_repos( repos );
+			fetch_all.refspecs = {"+refs/heads/*:refs/remotes/origin/*",
+			                      "+refs/tags/*:refs/tags/*"};
+			return git_runner( fetch_all, repos, in_folder( repos ), log_message );
+		}
+
+		// Only whether version could be a commit hash, a ref of the same name
+		// takes precedence
+		[[nodiscard]] bool is_commit_hash( std::string const &version ) {
+			return version.size( ) >= 7 and version.size( ) <= 40 and
+			       std::all_of( version.begin( ), version.end( ), []( char c ) {
+				       return std::isxdigit( static_cast<unsigned char>( c ) ) != 0;
+			       } );
+		}
+
+		struct local_version_t {
+			std::string commit{};
+			std::string head{};
+		};
+
+		// The commit that version names when it is a tag or a commit that is
+		// already present.  Refs are resolved first, like git does, and a
+		// hexadecimal version is only taken as a commit when no ref has that
+		// name.  Branches move, they always need a fetch
+		[[nodiscard]] std::optional<local_version_t>
+		find_local_version( fs::path const &repos, std::string const &version ) {
+			auto refs = std::string( );
+			if( not to_bool( git_runner( git_action_show_ref{}, repos,
+			                             in_folder( repos ),
+			                             std::back_inserter( refs ) ) ) ) {
+				return std::nullopt;
+			}
+			auto result = local_version_t{};
+			auto tag_commit = std::string( );
+			auto peeled_tag_commit = std::string( );
+			auto lines = std::istringstream( refs );
+			auto line = std::string( );
+			while( std::getline( lines, line ) ) {
+				auto const space = line.find( ' ' );
+				if( space == std::string::npos ) {
+					continue;
+				}
+				auto const sha = line.substr( 0, space );
+				auto const ref = line.substr( space + 1 );
+				if( ref == "HEAD" ) {
+					result.head = sha;
+				} else if( ref == "refs/tags/" + version ) {
+					tag_commit = sha;
+				} else if( ref == "refs/tags/" + version + "^{}" ) {
+					peeled_tag_commit = sha;
+				} else if( ref.size( ) > version.size( ) and
+				           ref.compare( ref.size( ) - version.size( ) - 1,
+				                        std::string::npos, '/' + version ) == 0 ) {
+					// A branch, or another ref that can move
+					return std::nullopt;
+				}
+			}
+			if( not peeled_tag_commit.empty( ) ) {
+				result.commit = peeled_tag_commit;
+			} else if( not tag_commit.empty( ) ) {
+				result.commit = tag_commit;
+			} else if( is_commit_hash( version ) ) {
+				if( version.size( ) == 40 and version == result.head ) {
+					result.commit = version;
 				} else {
-					result =
-					  git_runner( git_action_version{version}, repos, log_message );
+					auto out = std::string( );
+					if( not to_bool( git_runner(
+					      git_action_rev_parse{version + "^{commit}"}, repos,
+					      in_folder( repos ), std::back_inserter( out ) ) ) ) {
+						return std::nullopt;
+					}
+					out = trim( out );
+					// Anything else rev-parse resolved it to is not this commit
+					auto lower = version;
+					std::transform( lower.begin( ), lower.end( ), lower.begin( ),
+					                []( char c ) {
+						                return static_cast<char>(
+						                  std::tolower( static_cast<unsigned char>( c ) ) );
+					                } );
+					if( out.compare( 0, lower.size( ), lower ) != 0 ) {
+						return std::nullopt;
+					}
+					result.commit = out;
 				}
+			} else {
+				return std::nullopt;
+			}
+			return result;
+		}
+
+		[[nodiscard]] bool is_clean( fs::path const &repos ) {
+			auto out = std::string( );
+			return to_bool( git_runner( git_action_status{}, repos,
+			                            in_folder( repos ),
+			                            std::back_inserter( out ) ) ) and
+			       trim( out ).empty( );
+		}
+
+		// Checking out a commit leaves the submodules where they were
+		[[nodiscard]] action_status update_submodules( fs::path const &repos ) {
+			if( not exists( repos / ".gitmodules" ) ) {
+				return action_status::success;
+			}
+			return git_runner( git_action_submodule_update{}, repos,
+			                   in_folder( repos ), log_message );
+		}
+
+		// No fetching, the version is already here
+		[[nodiscard]] action_status
+		git_repos_use_local( fs::path const &repos, std::string const &version,
+		                     local_version_t const &local ) {
+			if( local.head == local.commit and is_clean( repos ) ) {
+				log_message << "git '" << repos << "' is already at " << version
+				            << '\n';
+				return update_submodules( repos );
+			}
+			log_message << "git checkout with '" << repos << "' to " << version
+			            << ", it is already present\n";
+			auto result = git_runner( git_action_reset( ), repos, in_folder( repos ),
+			                          log_message );
+			if( to_bool( result ) ) {
+				result = git_runner( git_action_version{version, is_worktree( repos )},
+				                     repos, in_folder( repos ), log_message );
+			}
+			if( to_bool( result ) ) {
+				result = update_submodules( repos );
 			}
 			return result;
 		}
 
+		// Fetch only, checkout cleans out any changes and moves the working tree
+		// to the requested version
 		[[nodiscard]] action_status git_repos_update( fs::path const &repos ) {
-			auto const chdir = change_directory( repos );
-			// Clean out any changes
-			auto result = git_runner( git_action_reset( ), repos, log_message );
-			if( result == action_status::success ) {
-				result = git_runner( git_action_pull{}, repos, log_message );
+			auto fetch = git_action_fetch{};
+			fetch.is_shallow = is_shallow_repos( repos );
+			return git_runner( fetch, repos, in_folder( repos ), log_message );
+		}
+
+		// One bare mirror per upstream, shared by every cache entry of it
+		[[nodiscard]] fs::path mirror_folder( fs::path const &cache_root,
+		                                      std::string const &uri ) {
+			auto const norm_uri = normalize_uri( uri );
+			auto name = norm_uri.substr( norm_uri.find_last_of( "/:" ) + 1 );
+			for( char &c : name ) {
+				if( not std::isalnum( static_cast<unsigned char>( c ) ) and
+				    c != '-' and c != '.' ) {
+					c = '_';
+				}
+			}
+			return cache_root / ".git_mirrors" /
+			       ( name + '-' + sha256_hex( norm_uri ).substr( 0, 16 ) + ".git" );
+		}
+
+		std::mutex &mirrors_mutex( ) {
+			static auto s_mutex = std::mutex( );
+			return s_mutex;
+		}
+
+		// Cache entries of the same upstream can be downloaded concurrently,
+		// anything changing the mirror itself holds its mutex
+		std::mutex &mirror_mutex( fs::path const &mirror ) {
+			static auto s_mirror_mutexes =
+			  std::unordered_map<std::string, std::mutex>( );
+			auto const lck = std::lock_guard<std::mutex>( mirrors_mutex( ) );
+			return s_mirror_mutexes[mirror.string( )];
+		}
+
+		// Fetches each mirror at most once per run
+		[[nodiscard]] action_status git_mirror_update( std::string const &uri,
+		                                               fs::path const &mirror ) {
+			static auto s_fetched = std::unordered_set<std::string>( );
+
+			auto const key = mirror.string( );
+			auto const mirror_lck =
+			  std::lock_guard<std::mutex>( mirror_mutex( mirror ) );
+			{
+				auto const lck = std::lock_guard<std::mutex>( mirrors_mutex( ) );
+				if( s_fetched.count( key ) > 0 ) {
+					return action_status::success;
+				}
+			}
+			fs::create_directories( mirror.parent_path( ) );
+			auto const lck =
+			  cache_lock( mirror_lock_file( mirror ), lock_modes::exclusive );
+			auto result = action_status::failure;
+			if( exists( mirror / "HEAD" ) ) {
+				log_message << "git fetch of '" << uri << "' into '" << mirror
+				            << "'\n";
+				result = git_runner( git_action_fetch{}, mirror, in_folder( mirror ),
+				                     log_message );
+			} else {
+				log_message << "git mirror of '" << uri << "' into '" << mirror
+				            << "'\n";
+				auto git_action = git_action_clone( );
+				git_action.remote_uri = uri;
+				git_action.is_mirror = true;
+				git_action.recurse_submodules = false;
+				result = git_runner( git_action, mirror,
+				                     in_folder( mirror.parent_path( ) ), log_message );
+				if( to_bool( result ) ) {
+					// Working trees borrow objects from the mirror, none may be pruned
+					result = git_runner( git_action_config{"gc.pruneExpire", "never"},
+					                     mirror, in_folder( mirror ), log_message );
+				}
+			}
+			if( to_bool( result ) ) {
+				mark_cache_used( mirror );
+				auto const lck = std::lock_guard<std::mutex>( mirrors_mutex( ) );
+				s_fetched.insert( key );
 			}
 			return result;
 		}
 
+		// Each version gets its own working tree of the mirror.  No clone, and
+		// the other versions keep their checkouts and builds
+		[[nodiscard]] action_status git_repos_add_worktree( fs::path const &mirror,
+		                                                    fs::path repos ) {
+			auto const mirror_lck =
+			  std::lock_guard<std::mutex>( mirror_mutex( mirror ) );
+			auto const lck =
+			  cache_lock( mirror_lock_file( mirror ), lock_modes::exclusive );
+			// Cache entries that were removed still have their working trees
+			// registered
+			auto result = git_runner( git_action_worktree_prune{}, mirror,
+			                          in_folder( mirror ), log_message );
+			if( not to_bool( result ) ) {
+				return result;
+			}
+			return git_runner( git_action_worktree_add{}, std::move( repos ),
+			                   in_folder( mirror ), log_message );
+		}
+
+		// The mirror was just fetched, a version it has no ref for is a commit
+		// that is only reachable by its hash.  Only its objects are fetched, the
+		// mirror's refs stay those of the upstream
 		[[nodiscard]] action_status
-		git_repos_clone( std::string const &remote_repos, fs::path repos ) {
+		git_mirror_fetch_version( fs::path const &mirror,
+		                          std::string const &version ) {
+			auto const mirror_lck =
+			  std::lock_guard<std::mutex>( mirror_mutex( mirror ) );
+			auto const lck =
+			  cache_lock( mirror_lock_file( mirror ), lock_modes::exclusive );
+			log_message << "fetching '" << version << "' into '" << mirror << "'\n";
+			auto fetch = git_action_fetch{};
+			fetch.refspecs.push_back( version );
+			if( to_bool( git_runner( fetch, mirror, in_folder( mirror ),
+			                         log_message ) ) and
+			    has_version( mirror, version ) ) {
+				return action_status::success;
+			}
+			log_error << "Could not find '" << version << "' in '" << mirror
+			          << "', commits that no ref names can only be fetched by "
+			             "their full hash\n";
+			return action_status::failure;
+		}
+
+		[[nodiscard]] action_status
+		git_repos_checkout( fs::path const &repos, fs::path const &mirror,
+		                    std::string version ) {
+			auto result = git_runner( git_action_reset( ), repos, in_folder( repos ),
+			                          log_message );
+			if( not to_bool( result ) ) {
+				return result;
+			}
+			if( version.empty( ) ) {
+				version = "master";
+			}
+			// Working trees of the mirror share its branches, a branch can only be
+			// checked out in one of them.  Their refs are the mirror's, so the
+			// detached commit is already what the mirror fetched
+			bool const detach = is_worktree( repos );
+			if( not has_version( repos, version ) ) {
+				// A working tree shares the mirror's refs and config, fetching in it
+				// would change them without the mirror's locks
+				auto const fetched = detach
+				                       ? git_mirror_fetch_version( mirror, version )
+				                       : git_repos_fetch( repos, version );
+				if( not to_bool( fetched ) ) {
+					return action_status::failure;
+				}
+			}
+			result = git_runner( git_action_version{version, detach}, repos,
+			                     in_folder( repos ), log_message );
+			if( to_bool( result ) and not is_detached_head( repos ) ) {
+				// A branch, move it to what update fetched.  After a shallow fetch
+				// the new tip does not descend from the old one
+				result = git_runner( git_action_reset{"@{upstream}"}, repos,
+				                     in_folder( repos ), log_message );
+			}
+			if( to_bool( result ) ) {
+				result = update_submodules( repos );
+			}
+			return result;
+		}
+
+		[[nodiscard]] action_status
+		git_repos_clone( std::string const &remote_repos, fs::path repos,
+		                 clone_strategies strategy, std::string const &version ) {
 
 			auto git_action = git_action_clone( );
 			git_action.remote_uri = remote_repos;
+			git_action.strategy = strategy;
 
-			return git_runner( git_action, std::move( repos ), log_message );
+			auto proc_opts = in_folder( repos.parent_path( ) );
+			if( not version.empty( ) and
+			    ( strategy == clone_strategies::shallow or
+			      strategy == clone_strategies::single_branch ) and
+			    remote_ref_kind( remote_repos, version, repos.parent_path( ) ) !=
+			      remote_ref_kinds::other ) {
+				// Clone the history of version instead of the default branch.  A
+				// commit cannot be cloned directly, checkout fetches it
+				git_action.branch = version;
+			}
+			return git_runner( git_action, std::move( repos ), std::move( proc_opts ),
+			                   log_message );
 		}
-
 	} // namespace
 
 	action_status download_git::download( glean_file_item const &dep,
-	                                      fs::path const &cache_folder ) const {
+	                                      fs::path const &cache_folder,
+	                                      glean_options const &opts ) const {
+		auto strategy = opts.clone_strategy;
+		if( not dep.clone_strategy.empty( ) ) {
+			auto cs = clone_strategy_from_string( dep.clone_strategy );
+			if( not cs ) {
+				log_error << "Unknown clone_strategy '" << dep.clone_strategy
+				          << "' for " << dep.provides << '\n';
+				return action_status::failure;
+			}
+			strategy = *cs;
+		}
+		auto const &version = dep.revision.empty( ) ? dep.version : dep.revision;
 		action_status result = action_status::failure;
 		auto repos = cache_folder / "source";
-		if( is_git_repos( repos ) ) {
+		if( is_git_repos( repos ) and not version.empty( ) ) {
+			if( auto local = find_local_version( repos, version ); local ) {
+				return git_repos_use_local( repos, version, *local );
+			}
+		}
+		// Limited clones talk to the upstream directly, a local mirror would
+		// hold its full history anyway
+		bool const use_mirror =
+		  strategy == clone_strategies::full or is_worktree( repos );
+		auto const mirror = mirror_folder( opts.glean_cache, dep.uri );
+		if( use_mirror and not to_bool( git_mirror_update( dep.uri, mirror ) ) ) {
+			return action_status::failure;
+		}
+		if( is_worktree( repos ) ) {
+			// Fetching the mirror updated it
+			result = action_status::success;
+		} else if( is_git_repos( repos ) ) {
 			log_message << "git update of '" << repos << "'\n";
 			result = git_repos_update( repos );
-		} else {
-			log_message << "git clone of '" << dep.uri << "' into '" << repos
+		} else if( use_mirror ) {
+			log_message << "git worktree of '" << mirror << "' in '" << repos
 			            << "'\n";
-			result = git_repos_clone( dep.uri, repos );
+			result = git_repos_add_worktree( mirror, repos );
+		} else {
+			log_message << "git clone(" << to_string( strategy ) << ") of '"
+			            << dep.uri << "' into '" << repos << "'\n";
+			result = git_repos_clone( dep.uri, repos, strategy, version );
 		}
 		if( to_bool( result ) ) {
-			log_message << "git checkout with '" << repos << "' to " << dep.version
+			log_message << "git checkout with '" << repos << "' to " << version
 			            << '\n';
-			return git_repos_checkout( repos, dep.version );
+			return git_repos_checkout( repos, mirror, version );
 		}
 		return result;
 	}
+
+	std::string
+	download_git::source_revision( fs::path const &cache_folder ) const {
+		auto const repos = cache_folder / "source";
+		if( not is_git_repos( repos ) ) {
+			return {};
+		}
+		auto result = std::string( );
+		if( not to_bool( git_runner( git_action_rev_parse{}, repos,
+		                             in_folder( repos ),
+		                             std::back_inserter( result ) ) ) ) {
+			return {};
+		}
+		return trim( result );
+	}
 } // namespace daw::glean
@@ -20,6 +20,7 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <iterator>
 #include <string>
 #include <utility>
 
@@ -37,7 +38,9 @@ namespace daw::glean {
 		}
 
 		[[nodiscard]] action_status svn_repos_update( fs::path repos ) {
-			return svn_runner( svn_action_update{}, std::move( repos ), log_message );
+			auto proc_opts = in_folder( repos );
+			return svn_runner( svn_action_update{}, std::move( repos ),
+			                   std::move( proc_opts ), log_message );
 		}
 
 		[[nodiscard]] action_status
@@ -46,13 +49,16 @@ namespace daw::glean {
 			auto svn_action = svn_action_checkout( );
 			svn_action.remote_uri = remote_repos;
 
-			return svn_runner( svn_action, std::move( repos ), log_message );
+			auto proc_opts = in_folder( repos.parent_path( ) );
+			return svn_runner( svn_action, std::move( repos ), std::move( proc_opts ),
+			                   log_message );
 		}
 
 	} // namespace
 
 	action_status download_svn::download( glean_file_item const &dep,
-	                                      fs::path const &cache_folder ) const {
+	                                      fs::path const &cache_folder,
+	                                      glean_options const & ) const {
 		auto result = action_status::failure;
 		auto repos = cache_folder / "source";
 		if( is_svn_repos( repos ) ) {
@@ -69,4 +75,20 @@ namespace daw::glean {
 		}
 		return result;
 	}
+
+	std::string
+	download_svn::source_revision( fs::path const &cache_folder ) const {
+		auto repos = cache_folder / "source";
+		if( not is_svn_repos( repos ) ) {
+			return {};
+		}
+		auto result = std::string( );
+		auto proc_opts = in_folder( repos );
+		if( not to_bool( svn_runner( svn_action_revision{}, std::move( repos ),
+		                             std::move( proc_opts ),
+		                             std::back_inserter( result ) ) ) ) {
+			return {};
+		}
+		return trim( result );
+	}
 } // namespace daw::glean
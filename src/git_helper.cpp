@@ -27,14 +27,32 @@
 #include "daw/glean/utilities.h"
 
 namespace daw::glean {
-	std::vector<std::string>
-	git_action_pull::build_args( fs::path const & ) const {
-		return {"pull", "--ff-only"};
-	}
-
 	std::vector<std::string>
 	git_action_clone::build_args( fs::path const &work_tree ) const {
 		auto result = std::vector<std::string>{"clone"};
+		if( is_mirror ) {
+			result.emplace_back( "--mirror" );
+		}
+		switch( strategy ) {
+		case clone_strategies::full:
+			break;
+		case clone_strategies::shallow:
+			result.emplace_back( "--depth=1" );
+			if( recurse_submodules ) {
+				result.emplace_back( "--shallow-submodules" );
+			}
+			break;
+		case clone_strategies::blobless:
+			result.emplace_back( "--filter=blob:none" );
+			break;
+		case clone_strategies::single_branch:
+			result.emplace_back( "--single-branch" );
+			break;
+		}
+		if( not branch.empty( ) ) {
+			result.emplace_back( "--branch" );
+			result.push_back( branch );
+		}
 		if( recurse_submodules ) {
 			result.emplace_back( "--recurse-submodules" );
 		}
@@ -45,11 +63,76 @@ namespace daw::glean {
 
 	std::vector<std::string>
 	git_action_version::build_args( fs::path const & ) const {
+		if( detach ) {
+			return {"checkout", "--detach", version};
+		}
 		return {"checkout", version};
 	}
 
+	std::vector<std::string>
+	git_action_rev_parse::build_args( fs::path const & ) const {
+		return {"rev-parse", "--verify", "--quiet", rev};
+	}
+
+	std::vector<std::string>
+	git_action_ls_remote::build_args( fs::path const & ) const {
+		return {"ls-remote", remote, name};
+	}
+
+	std::vector<std::string>
+	git_action_track_branch::build_args( fs::path const & ) const {
+		return {"remote", "set-branches", "--add", "origin", branch};
+	}
+
+	std::vector<std::string>
+	git_action_config::build_args( fs::path const & ) const {
+		return {"config", name, value};
+	}
+
+	std::vector<std::string>
+	git_action_fetch::build_args( fs::path const & ) const {
+		auto result = std::vector<std::string>{"fetch"};
+		if( unshallow ) {
+			result.emplace_back( "--unshallow" );
+		} else if( is_shallow ) {
+			result.emplace_back( "--depth=1" );
+		}
+		result.emplace_back( "origin" );
+		result.insert( result.end( ), refspecs.begin( ), refspecs.end( ) );
+		return result;
+	}
+
+	std::vector<std::string>
+	git_action_show_ref::build_args( fs::path const & ) const {
+		return {"show-ref", "--head", "--dereference"};
+	}
+
+	std::vector<std::string>
+	git_action_status::build_args( fs::path const & ) const {
+		return {"status", "--porcelain", "--untracked-files=no"};
+	}
+
 	std::vector<std::string>
 	git_action_reset::build_args( fs::path const & ) const {
-		return {"reset", "--hard"};
+		if( target.empty( ) ) {
+			return {"reset", "--hard"};
+		}
+		return {"reset", "--hard", target};
+	}
+
+	std::vector<std::string>
+	git_action_worktree_add::build_args( fs::path const &work_tree ) const {
+		return {"worktree", "add", "--no-checkout", "--detach",
+		        work_tree.string( )};
+	}
+
+	std::vector<std::string>
+	git_action_worktree_prune::build_args( fs::path const & ) const {
+		return {"worktree", "prune"};
+	}
+
+	std::vector<std::string>
+	git_action_submodule_update::build_args( fs::path const & ) const {
+		return {"submodule", "update", "--init", "--recursive"};
 	}
 } // namespace daw::glean
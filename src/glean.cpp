@@ -20,16 +20,27 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <boost/process/search_path.hpp>
 #include <boost/program_options.hpp>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "daw/daw_graph_algorithm.h"
+#include "daw/glean/artifact_cache.h"
+#include "daw/glean/artifact_http.h"
+#include "daw/glean/cache_gc.h"
+#include "daw/glean/compiler_cache.h"
 #include "daw/glean/glean_config.h"
 #include "daw/glean/glean_file.h"
 #include "daw/glean/glean_options.h"
+#include "daw/glean/jobserver.h"
 #include "daw/glean/logging.h"
+#include "daw/glean/toolchain.h"
 #include "daw/glean/utilities.h"
 
 namespace {
@@ -47,6 +58,64 @@ namespace {
 		}
 		return config;
 	}
+
+	// The command line overrides the config, no budget when neither has one
+	[[nodiscard]] std::optional<std::uintmax_t>
+	cache_size_limit( daw::glean::glean_config const &config,
+	                  daw::glean::glean_options const &opts ) {
+		auto const &limit = opts.cache_size_limit.empty( )
+		                      ? config.cache_size_limit
+		                      : opts.cache_size_limit;
+		if( limit.empty( ) ) {
+			return std::nullopt;
+		}
+		auto result = daw::glean::parse_size( limit );
+		if( not result ) {
+			log_error << "Invalid cache size limit '" << limit << "'\n";
+			exit( EXIT_FAILURE );
+		}
+		return result;
+	}
+
+	// The deepest folder holding both, or lhs when that is only the root
+	[[nodiscard]] daw::glean::fs::path
+	common_base( daw::glean::fs::path const &lhs,
+	             daw::glean::fs::path const &rhs ) {
+		auto const abs_lhs = daw::glean::fs::absolute( lhs ).lexically_normal( );
+		auto const abs_rhs = daw::glean::fs::absolute( rhs ).lexically_normal( );
+		auto result = daw::glean::fs::path( );
+		auto it = abs_rhs.begin( );
+		for( auto const &part : abs_lhs ) {
+			if( it == abs_rhs.end( ) or *it != part ) {
+				break;
+			}
+			result /= part;
+			++it;
+		}
+		if( result == result.root_path( ) ) {
+			return abs_lhs;
+		}
+		return result;
+	}
+
+	[[nodiscard]] int serve_cache( daw::glean::glean_options const &opts ) {
+		auto const colon = opts.listen.rfind( ':' );
+		auto port = 0UL;
+		if( colon != std::string::npos ) {
+			port = std::strtoul( opts.listen.c_str( ) + colon + 1, nullptr, 10 );
+		}
+		if( port == 0 or port > 65535 ) {
+			log_error << "Expected address:port to listen on, not '" << opts.listen
+			          << "'\n";
+			return EXIT_FAILURE;
+		}
+		auto const store = daw::glean::artifact_cache( opts.artifact_cache );
+		return to_bool( daw::glean::serve_artifact_cache(
+		         store, opts.listen.substr( 0, colon ),
+		         static_cast<uint16_t>( port ) ) )
+		         ? EXIT_SUCCESS
+		         : EXIT_FAILURE;
+	}
 } // namespace
 
 // Embed git version from define into binary.
@@ -61,19 +130,108 @@ char const GIT_VERSION[] = SOURCE_CONTROL_REVISION;
 int main( int argc, char **argv ) {
 	auto const config = setup_config( );
 	auto opts = daw::glean::glean_options( argc, argv );
+	daw::glean::set_verbose_output( opts.verbose );
+	auto const size_limit = cache_size_limit( config, opts );
+	if( not opts.command.empty( ) ) {
+		if( opts.command == std::vector<std::string>{"cache", "gc"} ) {
+			return to_bool( daw::glean::collect_cache_garbage( opts.glean_cache,
+			                                                   size_limit ) )
+			         ? EXIT_SUCCESS
+			         : EXIT_FAILURE;
+		}
+		if( opts.command == std::vector<std::string>{"cache", "migrate"} ) {
+			return to_bool( daw::glean::migrate_cache( opts.glean_cache ) )
+			         ? EXIT_SUCCESS
+			         : EXIT_FAILURE;
+		}
+		if( opts.command == std::vector<std::string>{"serve-cache"} ) {
+			return serve_cache( opts );
+		}
+		auto command = std::string( );
+		for( auto const &arg : opts.command ) {
+			command += command.empty( ) ? arg : ' ' + arg;
+		}
+		log_error << "Unknown command '" << command << "'\n";
+		return EXIT_FAILURE;
+	}
 	log_message << "glean cache: " << opts.glean_cache << '\n';
 	log_message << "install prefix: " << opts.install_prefix << '\n';
-	auto deps = daw::glean::process_config_file( "./glean.json", opts );
+	auto compiler_cache = std::optional<daw::glean::compiler_cache>( );
+	if( opts.output_type == daw::glean::output_types::process ) {
+		compiler_cache =
+		  daw::glean::find_compiler_cache( config, opts.glean_cache );
+		if( compiler_cache ) {
+			log_message << "compiler cache: " << compiler_cache->launcher( ) << '\n';
+			opts.compiler_launcher = compiler_cache->launcher( );
+			if( opts.relocatable ) {
+				compiler_cache->set_base_dir(
+				  common_base( opts.glean_cache, opts.install_prefix ) );
+			}
+			auto const env = compiler_cache->environment( );
+			opts.build_environment.insert( opts.build_environment.end( ),
+			                               env.begin( ), env.end( ) );
+			compiler_cache->snapshot_statistics( );
+		}
+		if( opts.multi_config and
+		    boost::process::search_path( "ninja" ).empty( ) ) {
+			log_message << "ninja was not found, each build type is configured in "
+			               "its own folder\n";
+			opts.multi_config = false;
+		}
+		auto const &toolchain = daw::glean::probe_toolchain( opts );
+		log_message << "toolchain: " << toolchain.id << '\n';
+		log_message << "  C compiler: " << toolchain.c_compiler << " ("
+		            << toolchain.c_version << ")\n";
+		log_message << "  C++ compiler: " << toolchain.cxx_compiler << " ("
+		            << toolchain.cxx_version << ")\n";
+		log_message << "  target: " << toolchain.target << '\n';
+	}
+	auto deps =
+	  opts.locked ? daw::graph_t<daw::glean::dependency>( )
+	              : daw::glean::process_config_file( "./glean.json", opts );
+	if( opts.locked ) {
+		if( not to_bool(
+		      daw::glean::process_lock_file( "./glean.lock", opts, deps ) ) ) {
+			return EXIT_FAILURE;
+		}
+	} else if( opts.output_type == daw::glean::output_types::process ) {
+		// Only a build records what it resolved
+		auto lock = daw::glean::glean_lock_file( );
+		if( not to_bool( daw::glean::make_lock_file( deps, opts, lock ) ) or
+		    not to_bool( daw::glean::write_lock_file( "./glean.lock", lock ) ) ) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Only glean's own builds can use it, cmake output builds nothing
+	auto const job_server = daw::glean::jobserver(
+	  opts.use_jobserver and
+	      opts.output_type == daw::glean::output_types::process
+	    ? opts.jobs
+	    : 0U,
+	  opts.build_jobs );
+	opts.use_jobserver = job_server.is_active( );
+	opts.ninja_joins_jobserver = job_server.ninja_joins( );
+	auto const job_server_env = job_server.environment( );
+	opts.build_environment.insert( opts.build_environment.end( ),
+	                               job_server_env.begin( ),
+	                               job_server_env.end( ) );
 
 	switch( opts.output_type ) {
 	case daw::glean::output_types::process:
-		if( opts.build_type == daw::glean::build_types::all ) {
-			opts.build_type = daw::glean::build_types::debug;
-			daw::glean::process_deps( std::move( deps ), opts );
-			opts.build_type = daw::glean::build_types::release;
-			daw::glean::process_deps( std::move( deps ), opts );
-		} else {
-			daw::glean::process_deps( std::move( deps ), opts );
+		if( not to_bool( daw::glean::process_deps( deps, opts ) ) ) {
+			daw::glean::log_status( "" );
+			if( compiler_cache ) {
+				compiler_cache->log_statistics( );
+			}
+			return EXIT_FAILURE;
+		}
+		daw::glean::log_status( "" );
+		if( compiler_cache ) {
+			compiler_cache->log_statistics( );
+		}
+		if( size_limit ) {
+			(void)daw::glean::collect_cache_garbage( opts.glean_cache, size_limit );
 		}
 		break;
 	case daw::glean::output_types::cmake:
@@ -20,9 +20,16 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <fstream>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <daw/daw_graph.h>
 #include <daw/daw_graph_algorithm.h>
@@ -30,13 +37,24 @@
 #include <daw/daw_read_file.h>
 #include <daw/json/daw_json_link.h>
 
+#include "daw/glean/artifact_cache.h"
+#include "daw/glean/artifact_http.h"
 #include "daw/glean/build_types.h"
+#include "daw/glean/cache_gc.h"
+#include "daw/glean/cache_lock.h"
 #include "daw/glean/dependency.h"
+#include "daw/glean/digest.h"
+#include "daw/glean/download_git.h"
 #include "daw/glean/download_types.h"
 #include "daw/glean/glean_file.h"
 #include "daw/glean/glean_file_item.h"
+#include "daw/glean/glean_lock.h"
 #include "daw/glean/glean_options.h"
+#include "daw/glean/graph_scheduler.h"
+#include "daw/glean/install_manifest.h"
 #include "daw/glean/logging.h"
+#include "daw/glean/task_pool.h"
+#include "daw/glean/toolchain.h"
 
 namespace daw::glean {
 	namespace {
@@ -72,21 +90,104 @@ namespace daw::glean {
 		}
 
 		void ensure_cache_folder_structure( fs::path const &cache_folder_name ) {
-			if( not is_directory( cache_folder_name ) ) {
+			// Another glean may be creating the same folders, neither call fails
+			// when they exist
+			if( not is_directory( cache_folder_name / "build" ) ) {
 				log_message << "Building cache folder's subfolders(source and build): "
 				            << cache_folder_name << '\n';
 				fs::create_directories( cache_folder_name / "source" );
-				fs::create_directory( cache_folder_name / "build" );
+				fs::create_directories( cache_folder_name / "build" );
 			}
 		}
 
 		[[nodiscard]] fs::path cache_folder( glean_options const &opts,
 		                                     glean_file_item const &dep ) {
-			auto const dep_hash =
-			  std::to_string( std::hash<glean_file_item>{}( dep ) );
-			return opts.glean_cache / dep.provides / dep_hash;
+			return dep.cache_folder( opts.glean_cache, opts.cmake_args );
 		}
 
+		// Held exclusively while building and installing one build type
+		[[nodiscard]] fs::path build_lock_file( fs::path const &cache_folder_name,
+		                                        daw::glean::build_types bt ) {
+			return cache_folder_name / "build" / ( to_string( bt ) + ".lock" );
+		}
+
+		[[nodiscard]] action_status download_item( glean_file_item const &dep,
+		                                           fs::path const &cache_path,
+		                                           glean_options const &opts ) {
+			auto const label = log_label_scope( dep.provides );
+			log_message << "\n-------------------------------------\n";
+			log_message << "Downloading - " << dep.provides << '\n';
+			log_message << "-------------------------------------\n\n";
+
+			auto const lck =
+			  cache_lock( source_lock_file( cache_path ), lock_modes::exclusive );
+			mark_cache_used( cache_path );
+			return download_types_t( dep.download_type )
+			  .download( dep, cache_path, opts );
+		}
+
+		// Downloads that have been run ahead of the serial graph merge, keyed by
+		// the cache folder they populated
+		class prefetch_results_t {
+			std::unordered_map<std::string, action_status> m_results{};
+
+		public:
+			/// @brief Download every item accepted by should_fetch concurrently
+			/// and record the results.  Items sharing a cache folder are only
+			/// downloaded once
+			template<typename Predicate>
+			void prefetch( std::vector<glean_file_item> const &items,
+			               glean_options const &opts, Predicate should_fetch ) {
+				struct fetch_job_t {
+					glean_file_item const *item;
+					fs::path cache_path;
+					action_status result = action_status::failure;
+				};
+				auto jobs = std::vector<fetch_job_t>( );
+				for( glean_file_item const &item : items ) {
+					auto dep_cache_folder = cache_folder( opts, item );
+					if( m_results.count( dep_cache_folder.string( ) ) > 0 or
+					    std::any_of( jobs.cbegin( ), jobs.cend( ),
+					                 [&]( fetch_job_t const &j ) {
+						                 return j.cache_path == dep_cache_folder;
+					                 } ) ) {
+						continue;
+					}
+					ensure_cache_folder_structure( dep_cache_folder );
+					if( should_fetch( item, dep_cache_folder ) ) {
+						jobs.push_back( {&item, std::move( dep_cache_folder )} );
+					}
+				}
+				if( jobs.size( ) < 2U or opts.fetch_jobs < 2U ) {
+					// Nothing to gain, let the serial path download it
+					return;
+				}
+				{
+					auto pool = task_pool( static_cast<uint32_t>(
+					  std::min<size_t>( opts.fetch_jobs, jobs.size( ) ) ) );
+					for( fetch_job_t &job : jobs ) {
+						pool.add_task( [&job, &opts]( ) {
+							job.result =
+							  download_item( *job.item, job.cache_path, opts );
+						} );
+					}
+					pool.wait( );
+				}
+				for( fetch_job_t const &job : jobs ) {
+					m_results[job.cache_path.string( )] = job.result;
+				}
+			}
+
+			[[nodiscard]] std::optional<action_status>
+			find( fs::path const &cache_path ) const {
+				if( auto pos = m_results.find( cache_path.string( ) );
+				    pos != m_results.end( ) ) {
+					return pos->second;
+				}
+				return std::nullopt;
+			}
+		};
+
 		template<typename T>
 		[[nodiscard]] auto
 		merge_cfg_item( find_dep_by_name_t<T> const &find_dep_by_name,
@@ -121,14 +222,16 @@ namespace daw::glean {
 		}
 	} // namespace
 
-	[[nodiscard]] action_status downloader( glean_file_item &child_dep,
-	                                        fs::path const &cache_path ) {
+	[[nodiscard]] action_status
+	downloader( glean_file_item &child_dep, fs::path const &cache_path,
+	            glean_options const &opts,
+	            prefetch_results_t const &prefetched ) {
 
-		log_message << "\n-------------------------------------\n";
-		log_message << "Downloading - " << child_dep.provides << '\n';
-		log_message << "-------------------------------------\n\n";
-		if( not to_bool( download_types_t( child_dep.download_type )
-		                   .download( child_dep, cache_path ) ) ) {
+		auto result = prefetched.find( cache_path );
+		if( not result ) {
+			result = download_item( child_dep, cache_path, opts );
+		}
+		if( not to_bool( *result ) ) {
 
 			log_error << "Error downloading\n";
 			exit( EXIT_FAILURE );
@@ -139,7 +242,8 @@ namespace daw::glean {
 	[[nodiscard]] action_status
 	download_node( glean_file_item &child_dep, fs::path const &cache_folder,
 	               daw::graph_t<dependency> &known_deps,
-	               glean_options const &opts ) {
+	               glean_options const &opts,
+	               prefetch_results_t const &prefetched ) {
 
 		// Check if we have downloaded this resource already
 		auto const find_dep_by_name = find_dep_by_name_t( known_deps );
@@ -151,7 +255,8 @@ namespace daw::glean {
 				return action_status::success;
 			}
 		}
-		action_status result = downloader( child_dep, cache_folder );
+		action_status result =
+		  downloader( child_dep, cache_folder, opts, prefetched );
 		if( dep ) {
 			dep->has_downloaded( ) = to_bool( result );
 		}
@@ -167,14 +272,16 @@ namespace daw::glean {
 	std::optional<daw::node_id_t>
 	process_config_item( daw::graph_t<dependency> &known_deps,
 	                     glean_options const &opts, glean_file_item &child_item,
-	                     daw::node_id_t parent_id );
+	                     daw::node_id_t parent_id,
+	                     prefetch_results_t &prefetched );
 
 	template<typename T>
 	[[nodiscard]] action_status
 	process_dependency( daw::graph_t<dependency> &known_deps,
 	                    glean_options const &opts, glean_file_item &child_dep,
 	                    find_dep_by_name_t<T> const &find_dep_by_name,
-	                    node_id_t parent_node_id ) {
+	                    node_id_t parent_node_id,
+	                    prefetch_results_t &prefetched ) {
 
 		auto existing_dep_id = find_dep_by_name( child_dep.provides );
 
@@ -182,7 +289,8 @@ namespace daw::glean {
 		ensure_cache_folder_structure( dep_cache_folder );
 
 		if( not to_bool(
-		      download_node( child_dep, dep_cache_folder, known_deps, opts ) ) and
+		      download_node( child_dep, dep_cache_folder, known_deps, opts,
+		                     prefetched ) ) and
 		    not child_dep.is_optional ) {
 			return action_status::failure;
 		}
@@ -206,7 +314,8 @@ namespace daw::glean {
 		known_deps.add_directed_edge( parent_node_id, dep_id );
 
 		if( has_glean ) {
-			(void)process_config_item( known_deps, opts, child_dep, dep_id );
+			(void)process_config_item( known_deps, opts, child_dep, dep_id,
+			                           prefetched );
 		}
 		return action_status::success;
 	}
@@ -214,7 +323,8 @@ namespace daw::glean {
 	[[nodiscard]] std::optional<daw::node_id_t>
 	process_config_item( daw::graph_t<dependency> &known_deps,
 	                     glean_options const &opts, glean_file_item &child_item,
-	                     daw::node_id_t parent_id ) {
+	                     daw::node_id_t parent_id,
+	                     prefetch_results_t &prefetched ) {
 
 		auto const cache_root = cache_folder( opts, child_item );
 		ensure_cache_folder_structure( cache_root );
@@ -229,7 +339,8 @@ namespace daw::glean {
 		}
 		auto const glean_cfg_file = cache_root / "source" / "glean.json";
 		if( is_empty( cache_root / "source" ) ) {
-			if( not to_bool( downloader( child_item, cache_root ) ) and
+			if( not to_bool(
+			      downloader( child_item, cache_root, opts, prefetched ) ) and
 			    not child_item.is_optional ) {
 				return {};
 			}
@@ -238,17 +349,34 @@ namespace daw::glean {
 			return id.node_id;
 		}
 
-		auto glean_cfg_data = daw::json::from_json<glean_config_file>(
-		  daw::read_file( glean_cfg_file.c_str( ) ).value( ) );
+		auto glean_cfg_data = [&] {
+			auto const lck =
+			  cache_lock( source_lock_file( cache_root ), lock_modes::shared );
+			return daw::json::from_json<glean_config_file>(
+			  daw::read_file( glean_cfg_file.c_str( ) ).value( ) );
+		}( );
 
 		validate_config_file( glean_cfg_data, glean_cfg_file, child_item.provides );
 
 		if( glean_cfg_data.dependencies.empty( ) or not id.is_new ) {
 			return id.node_id;
 		}
+		// Siblings are downloaded concurrently, the graph is then merged in
+		// order so that the first seen dependency still wins
+		prefetched.prefetch(
+		  glean_cfg_data.dependencies, opts,
+		  [&]( glean_file_item const &child_dep, fs::path const & ) {
+			  if( auto node_id = find_dep_by_name( child_dep.provides ); node_id ) {
+				  return not( opts.use_first and known_deps.get_raw_node( *node_id )
+				                                   .value( )
+				                                   .has_downloaded( ) );
+			  }
+			  return true;
+		  } );
+
 		for( glean_file_item &child_dep : glean_cfg_data.dependencies ) {
 			(void)process_dependency( known_deps, opts, child_dep, find_dep_by_name,
-			                          id.node_id );
+			                          id.node_id, prefetched );
 		}
 		return id.node_id;
 	}
@@ -287,8 +415,18 @@ namespace daw::glean {
 					break;
 				}
 			}
-			auto child_id =
-			  process_config_item( known_deps, opts, dep, root_node_id );
+		}
+
+		auto prefetched = prefetch_results_t( );
+		prefetched.prefetch( cfg_file.dependencies, opts,
+		                     []( glean_file_item const &,
+		                         fs::path const &dep_cache_folder ) {
+			                     return is_empty( dep_cache_folder / "source" );
+		                     } );
+
+		for( glean_file_item &dep : cfg_file.dependencies ) {
+			auto child_id = process_config_item( known_deps, opts, dep,
+			                                     root_node_id, prefetched );
 			if( not child_id ) {
 				if( dep.is_optional ) {
 					continue;
@@ -301,24 +439,688 @@ namespace daw::glean {
 		return known_deps;
 	}
 
-	void process_deps( daw::graph_t<dependency> const &known_deps,
-	                   glean_options const &opts ) {
+	action_status process_lock_file( fs::path const &lock_file_path,
+	                                 glean_options const &opts,
+	                                 daw::graph_t<dependency> &known_deps ) {
+
+		auto lock = glean_lock_file( );
+		if( not to_bool( read_lock_file( lock_file_path, lock ) ) ) {
+			return action_status::failure;
+		}
+		if( opts.output_type == output_types::process and
+		    not lock.toolchain.empty( ) and
+		    lock.toolchain != toolchain_id( opts ) ) {
+			log_message << "glean.lock was written with toolchain "
+			            << lock.toolchain << ", this build uses "
+			            << toolchain_id( opts ) << '\n';
+		}
+
+		struct locked_dep_t {
+			glean_file_item item;
+			fs::path cache_path;
+			action_status result = action_status::failure;
+		};
+		auto locked_deps = std::vector<locked_dep_t>( );
+		for( glean_lock_item const &locked : lock.dependencies ) {
+			// Without one the download would quietly take the tip of version
+			if( daw::string_view( locked.download_type ) == download_git::type_id and
+			    locked.revision.empty( ) ) {
+				log_error << "glean.lock has no revision for " << locked.provides
+				          << ", run without --locked to record one\n";
+				return action_status::failure;
+			}
+			auto item = glean_file_item( );
+			item.provides = locked.provides;
+			item.download_type = locked.download_type;
+			item.build_type = locked.build_type;
+			item.uri = locked.uri;
+			item.version = locked.version;
+			item.revision = locked.revision;
+			item.cmake_args = locked.cmake_args;
+			item.custom_options = locked.custom_options;
+			item.clone_strategy = locked.clone_strategy;
+			item.package_name = locked.package_name;
+			item.target = locked.target;
+			item.is_optional = locked.is_optional;
+			auto cache_path = cache_folder( opts, item );
+			ensure_cache_folder_structure( cache_path );
+			locked_deps.push_back( {std::move( item ), std::move( cache_path )} );
+		}
+		{
+			// The graph is already known, so every download can start at once
+			auto pool = task_pool( static_cast<uint32_t>( std::max<size_t>(
+			  1U, std::min<size_t>( opts.fetch_jobs, locked_deps.size( ) ) ) ) );
+			for( locked_dep_t &locked_dep : locked_deps ) {
+				pool.add_task( [&locked_dep, &opts]( ) {
+					locked_dep.result = download_item( locked_dep.item,
+					                                   locked_dep.cache_path, opts );
+				} );
+			}
+			pool.wait( );
+		}
+
+		auto const root_node_id = known_deps.add_node(
+		  lock.provides,
+		  build_types_t( "none", "", opts.install_prefix, opts, false ) );
+
+		auto node_ids = std::unordered_map<std::string, daw::node_id_t>( );
+		for( locked_dep_t const &locked_dep : locked_deps ) {
+			if( not to_bool( locked_dep.result ) ) {
+				if( locked_dep.item.is_optional ) {
+					continue;
+				}
+				log_error << "failure to download required dependency "
+				          << locked_dep.item.provides << '\n';
+				return action_status::failure;
+			}
+			bool const has_glean = is_glean_project( locked_dep.cache_path );
+			auto builder =
+			  build_types_t( locked_dep.item.build_type, locked_dep.cache_path,
+			                 opts.install_prefix, opts, has_glean );
+			node_ids[locked_dep.item.provides] = known_deps.add_node(
+			  dependency( locked_dep.item.provides, daw::move( builder ),
+			              locked_dep.item ) );
+		}
+
+		auto const add_edges = [&]( daw::node_id_t parent_id,
+		                            std::vector<std::string> const &depends ) {
+			for( auto const &name : depends ) {
+				// Optional dependencies that failed to download have no node
+				if( auto pos = node_ids.find( name ); pos != node_ids.end( ) ) {
+					known_deps.add_directed_edge( parent_id, pos->second );
+				}
+			}
+		};
+		add_edges( root_node_id, lock.depends );
+		for( glean_lock_item const &locked : lock.dependencies ) {
+			if( auto pos = node_ids.find( locked.provides );
+			    pos != node_ids.end( ) ) {
+				add_edges( pos->second, locked.depends );
+			}
+		}
+		return action_status::success;
+	}
+
+	action_status make_lock_file( daw::graph_t<dependency> const &known_deps,
+	                              glean_options const &opts,
+	                              glean_lock_file &lock ) {
+		lock = glean_lock_file( );
+		lock.toolchain = toolchain_id( opts );
+		auto result = action_status::success;
+		auto const depends_of = [&]( auto const &node ) {
+			auto result = std::vector<std::string>( );
+			for( auto child_id : node.outgoing_edges( ) ) {
+				result.push_back(
+				  known_deps.get_raw_node( child_id ).value( ).name( ) );
+			}
+			std::sort( result.begin( ), result.end( ) );
+			return result;
+		};
+		known_deps.visit( [&]( auto const &node ) {
+			dependency const &dep = node.value( );
+			if( not dep.has_file_dep( ) ) {
+				lock.provides = dep.name( );
+				lock.depends = depends_of( node );
+				return;
+			}
+			glean_file_item const &file_dep = dep.file_dep( );
+			auto item = glean_lock_item( );
+			item.provides = dep.name( );
+			item.download_type = file_dep.download_type;
+			item.build_type = file_dep.build_type;
+			item.uri = file_dep.uri;
+			item.version = file_dep.version;
+			if( daw::string_view( file_dep.download_type ) ==
+			    download_git::type_id ) {
+				item.revision = download_types_t( file_dep.download_type )
+				                  .source_revision( cache_folder( opts, file_dep ) );
+				if( item.revision.empty( ) ) {
+					log_error << "Could not find the revision of " << dep.name( )
+					          << " to record in glean.lock\n";
+					result = action_status::failure;
+				}
+			}
+			item.cmake_args = file_dep.cmake_args;
+			item.custom_options = file_dep.custom_options;
+			item.clone_strategy = file_dep.clone_strategy;
+			item.package_name = file_dep.package_name;
+			item.target = file_dep.target;
+			item.depends = depends_of( node );
+			item.is_optional = file_dep.is_optional;
+			lock.dependencies.push_back( std::move( item ) );
+		} );
+		std::sort( lock.dependencies.begin( ), lock.dependencies.end( ),
+		           []( glean_lock_item const &lhs, glean_lock_item const &rhs ) {
+			           return lhs.provides < rhs.provides;
+		           } );
+		return result;
+	}
+
+	namespace {
+		[[nodiscard]] fs::path fingerprint_file( glean_options const &opts,
+		                                         glean_file_item const &dep,
+		                                         daw::glean::build_types bt ) {
+			return cache_folder( opts, dep ) / "build" /
+			       ( to_string( bt ) + ".fingerprint" );
+		}
+
+		[[nodiscard]] std::string read_fingerprint( fs::path const &file ) {
+			auto in = std::ifstream( file );
+			auto result = std::string( );
+			std::getline( in, result );
+			return result;
+		}
+
+		void write_fingerprint( fs::path const &file,
+		                        std::string const &fingerprint ) {
+			auto out = std::ofstream( file, std::ios::trunc );
+			out << fingerprint << '\n';
+		}
+
+		// The digest of what the last successful install put into the prefix,
+		// stored next to the fingerprint
+		[[nodiscard]] fs::path outputs_file( glean_options const &opts,
+		                                     glean_file_item const &dep,
+		                                     daw::glean::build_types bt ) {
+			return cache_folder( opts, dep ) / "build" /
+			       ( to_string( bt ) + ".outputs" );
+		}
+
+		// The closure digest of what the node and everything below it installed,
+		// stored next to the outputs
+		[[nodiscard]] fs::path closure_file( glean_options const &opts,
+		                                     glean_file_item const &dep,
+		                                     daw::glean::build_types bt ) {
+			return cache_folder( opts, dep ) / "build" /
+			       ( to_string( bt ) + ".closure" );
+		}
+
+		// A digest of the paths and contents of every file listed in an install
+		// manifest.  Empty when one can no longer be read
+		[[nodiscard]] std::string hash_installed_files( fs::path const &manifest ) {
+			auto in = std::ifstream( manifest );
+			if( not in ) {
+				return {};
+			}
+			auto paths = std::vector<std::string>( );
+			auto line = std::string( );
+			while( std::getline( in, line ) ) {
+				if( not line.empty( ) ) {
+					paths.push_back( std::move( line ) );
+				}
+			}
+			std::sort( paths.begin( ), paths.end( ) );
+			auto digest = sha256( );
+			digest.update_field( "glean outputs 1" );
+			auto buffer = std::string( 64U * 1024U, '\0' );
+			for( auto const &path : paths ) {
+				digest.update_field( path );
+				if( is_symlink( fs::path( path ) ) ) {
+					digest.update_field( "symlink" ).update_field(
+					  read_symlink( fs::path( path ) ).string( ) );
+					continue;
+				}
+				auto file = std::ifstream( path, std::ios::binary );
+				if( not file ) {
+					return {};
+				}
+				while( file.read( buffer.data( ), buffer.size( ) ) or
+				       file.gcount( ) > 0 ) {
+					digest.update( std::string_view(
+					  buffer.data( ), static_cast<size_t>( file.gcount( ) ) ) );
+				}
+				digest.update_field( "" );
+			}
+			return digest.hex_digest( );
+		}
+
+		// Builds and installs every node once all of the nodes it depends on,
+		// its outgoing edges, have installed, with each requested build type as
+		// a config of the graph_scheduler.  A node whose fingerprint matches the
+		// one stored after its last successful install is not built again.
+		// Fingerprints cover what the dependencies and everything below them
+		// installed rather than how they were built, so a dependency rebuilt
+		// into identical files, with nothing below it changed, leaves its
+		// dependents alone
+		class build_scheduler_t {
+			struct node_keys_t {
+				std::string fingerprint{};
+				std::string artifact_key{};
+				// The artifact key with the install prefix in it.  The same as
+				// artifact_key unless the build can be relocatable
+				std::string local_artifact_key{};
+				// Known once the node has installed, see hash_installed_files
+				std::string outputs{};
+				// The closures of the node's dependencies
+				std::string dependencies{};
+				// The outputs of the node and the closures of its dependencies, what
+				// the node passes up to its dependents.  Known once it has installed
+				std::string closure{};
+			};
+
+			daw::graph_t<dependency> const *m_known_deps;
+			glean_options const *m_opts;
+			std::vector<daw::glean::build_types> m_build_types;
+			std::optional<artifact_cache> m_artifacts{};
+			std::optional<artifact_client> m_artifact_server{};
+			// Uploads to the artifact server do not hold up the builds
+			std::optional<task_pool> m_uploads{};
+			std::mutex m_mutex{};
+			// The keys of the nodes that have installed
+			std::vector<std::unordered_map<daw::node_id_t, node_keys_t>> m_keys;
+
+			// The fingerprint covers the source revision, the build inputs, the
+			// toolchain and the closures of the dependencies.  The artifact
+			// key covers the artifact keys of the dependencies instead and has no
+			// paths into this machine's cache, so that other machines sharing the
+			// artifact cache compute the same one.  Either is empty when something
+			// it covers is unknown
+			[[nodiscard]] node_keys_t keys( size_t config, daw::node_id_t id ) {
+				auto const &node = m_known_deps->get_raw_node( id );
+				auto const &cur_dep = node.value( );
+				struct child_keys_t {
+					std::string name;
+					bool has_file_dep;
+					node_keys_t keys;
+					cmake_package_t package;
+				};
+				auto child_keys = std::vector<child_keys_t>( );
+				{
+					auto const lck = std::lock_guard<std::mutex>( m_mutex );
+					for( auto child_id : node.outgoing_edges( ) ) {
+						auto const &child = m_known_deps->get_raw_node( child_id ).value( );
+						child_keys.push_back(
+						  {child.name( ), child.has_file_dep( ), m_keys[config][child_id],
+						   child.has_file_dep( ) ? child.file_dep( ).cmake_package( )
+						                         : cmake_package_t{}} );
+					}
+				}
+				std::sort( child_keys.begin( ), child_keys.end( ),
+				           []( child_keys_t const &lhs, child_keys_t const &rhs ) {
+					           return lhs.name < rhs.name;
+				           } );
+				auto result = node_keys_t{};
+				auto dependencies = sha256( );
+				dependencies.update_field( "glean dependencies 2" );
+				bool has_dependencies = true;
+				for( auto const &child : child_keys ) {
+					// A header only package config names the packages of its children
+					dependencies.update_field( child.name )
+					  .update_field( child.keys.closure )
+					  .update_field( child.package.name )
+					  .update_field( child.package.target );
+					if( child.has_file_dep and child.keys.closure.empty( ) ) {
+						has_dependencies = false;
+					}
+				}
+				if( has_dependencies ) {
+					result.dependencies = dependencies.hex_digest( );
+				}
+				if( not cur_dep.has_file_dep( ) ) {
+					// Nothing of its own is installed, it passes its dependencies on
+					result.closure = result.dependencies;
+					return result;
+				}
+				auto const bt = m_build_types[config];
+				auto const &file_dep = cur_dep.file_dep( );
+				auto const revision =
+				  download_types_t( file_dep.download_type )
+				    .source_revision( cache_folder( *m_opts, file_dep ) );
+				if( revision.empty( ) ) {
+					return result;
+				}
+
+				auto fingerprint = sha256( );
+				fingerprint.update_field( "glean fingerprint 2" )
+				  .update_field( revision )
+				  .update_field( to_string( bt ) )
+				  .update_field( toolchain_id( *m_opts ) )
+				  .update_field( m_opts->install_prefix.string( ) );
+				for( auto const &arg : cur_dep.build_inputs( bt ) ) {
+					fingerprint.update_field( arg );
+				}
+				fingerprint.update_field( result.dependencies );
+				if( not result.dependencies.empty( ) ) {
+					result.fingerprint = fingerprint.hex_digest( );
+				}
+				// Installed files may refer to the install prefix, it stays part of
+				// the artifact key unless the build keeps it out of them
+				auto const artifact_key = [&]( std::string const &location ) {
+					auto digest = sha256( );
+					digest.update_field( "glean artifact 2" )
+					  .update_field( file_dep.cache_key( m_opts->cmake_args ) )
+					  .update_field( revision )
+					  .update_field( to_string( bt ) )
+					  .update_field( toolchain_id( *m_opts ) )
+					  .update_field( location );
+					for( auto const &child : child_keys ) {
+						digest.update_field( child.name )
+						  .update_field( child.keys.artifact_key );
+					}
+					return digest.hex_digest( );
+				};
+				for( auto const &child : child_keys ) {
+					if( child.has_file_dep and child.keys.artifact_key.empty( ) ) {
+						return result;
+					}
+				}
+				result.local_artifact_key =
+				  artifact_key( m_opts->install_prefix.string( ) );
+				result.artifact_key = is_relocatable( )
+				                        ? artifact_key( "relocatable" )
+				                        : result.local_artifact_key;
+				return result;
+			}
+
+			// Without the prefix map compiled code keeps the paths of this
+			// machine, whatever glean does to the installed files
+			[[nodiscard]] bool is_relocatable( ) const {
+				return m_opts->relocatable and
+				       probe_toolchain( *m_opts ).has_prefix_map;
+			}
+
+			[[nodiscard]] bool fetch_artifact( std::string const &key ) {
+				if( not m_artifact_server ) {
+					return false;
+				}
+				auto const partial = m_artifacts->partial_path( key );
+				if( to_bool( m_artifact_server->download( key, partial ) ) ) {
+					// Another build may have fetched the same key in the meantime
+					(void)m_artifacts->commit( partial, key );
+					log_message << "Fetched artifact " << key << '\n';
+					return true;
+				}
+				if( exists( partial ) ) {
+					fs::remove( partial );
+				}
+				return false;
+			}
+
+			void upload_artifact( std::string const &key ) {
+				if( not m_artifact_server ) {
+					return;
+				}
+				m_uploads->add_task( [this, key]( ) {
+					if( m_artifact_server->contains( key ) ) {
+						return;
+					}
+					if( not to_bool( m_artifact_server->upload(
+					      key, m_artifacts->archive_path( key ) ) ) ) {
+						log_message << "Could not upload artifact " << key << '\n';
+					}
+				} );
+			}
+
+			// Unpacks a stored archive of what the node installed, when there is one
+			[[nodiscard]] bool restore_artifact( dependency const &cur_dep,
+			                                     daw::glean::build_types bt,
+			                                     std::string const &key ) {
+				auto const manifest = cur_dep.install_manifest( bt );
+				if( not m_artifacts or key.empty( ) or manifest.empty( ) ) {
+					return false;
+				}
+				if( not m_artifacts->contains( key ) and not fetch_artifact( key ) ) {
+					return false;
+				}
+				log_message << "Restoring - " << cur_dep.name( ) << " ("
+				            << to_string( bt ) << ") from artifact " << key << '\n';
+				if( not to_bool( m_artifacts->restore(
+				      key, m_opts->install_prefix / to_string( bt ), manifest ) ) ) {
+					log_message << "Could not restore artifact " << key
+					            << ", building instead\n";
+					return false;
+				}
+				return true;
+			}
+
+			// A relocatable build is only shared once nothing it installed names
+			// the install prefix or the cache, otherwise it is kept to this prefix
+			void store_artifact( dependency const &cur_dep,
+			                     daw::glean::build_types bt,
+			                     node_keys_t const &keys ) {
+				auto const manifest = cur_dep.install_manifest( bt );
+				auto key = keys.artifact_key;
+				if( not m_artifacts or key.empty( ) or manifest.empty( ) ) {
+					return;
+				}
+				if( key != keys.local_artifact_key and
+				    installed_files_contain(
+				      manifest, {m_opts->install_prefix.string( ),
+				                 m_opts->glean_cache.string( )} ) ) {
+					log_message << "Installed files of " << cur_dep.name( ) << " ("
+					            << to_string( bt )
+					            << ") still contain paths of this machine, its "
+					               "artifact is only used with this install prefix\n";
+					key = keys.local_artifact_key;
+				}
+				if( not to_bool( m_artifacts->store(
+				      key, m_opts->install_prefix / to_string( bt ), manifest ) ) ) {
+					log_message << "Could not store artifact " << key << " of "
+					            << cur_dep.name( ) << '\n';
+					return;
+				}
+				upload_artifact( key );
+			}
+
+			// Empty when either part is unknown
+			static void set_closure( node_keys_t &keys ) {
+				keys.closure.clear( );
+				if( keys.outputs.empty( ) or keys.dependencies.empty( ) ) {
+					return;
+				}
+				keys.closure = sha256( )
+				                 .update_field( "glean closure 1" )
+				                 .update_field( keys.outputs )
+				                 .update_field( keys.dependencies )
+				                 .hex_digest( );
+			}
+
+			// Records what the node installed.  Without an install manifest the
+			// fingerprint has to stand in for it
+			void record_outputs( dependency const &cur_dep,
+			                     daw::glean::build_types bt, node_keys_t &keys ) {
+				auto const manifest = cur_dep.install_manifest( bt );
+				keys.outputs = manifest.empty( ) ? keys.fingerprint
+				                                 : hash_installed_files( manifest );
+				set_closure( keys );
+				auto const file = outputs_file( *m_opts, cur_dep.file_dep( ), bt );
+				auto const c_file = closure_file( *m_opts, cur_dep.file_dep( ), bt );
+				auto const previous = read_fingerprint( c_file );
+				for( auto const &f : {file, c_file} ) {
+					if( exists( f ) ) {
+						fs::remove( f );
+					}
+				}
+				if( keys.outputs.empty( ) ) {
+					return;
+				}
+				write_fingerprint( file, keys.outputs );
+				if( keys.closure.empty( ) ) {
+					return;
+				}
+				write_fingerprint( c_file, keys.closure );
+				// Dependents are only kept when nothing below them changed either
+				if( keys.closure == previous ) {
+					log_message << "Installed files of " << cur_dep.name( ) << " ("
+					            << to_string( bt )
+					            << ") and its dependencies are unchanged, its "
+					               "dependents are kept\n";
+				}
+			}
+
+			// The packages of the nodes id depends on, by name.  Only those whose
+			// names are known, the header only packages glean writes and those a
+			// dependency declares.  A guess from provides could name a package
+			// the child never installs
+			[[nodiscard]] std::vector<cmake_package_t>
+			dependency_packages( daw::node_id_t id ) const {
+				auto result = std::vector<cmake_package_t>( );
+				for( auto child_id :
+				     m_known_deps->get_raw_node( id ).outgoing_edges( ) ) {
+					auto const &child = m_known_deps->get_raw_node( child_id ).value( );
+					if( not child.has_file_dep( ) ) {
+						continue;
+					}
+					auto const &file_dep = child.file_dep( );
+					if( daw::string_view( file_dep.build_type ) ==
+					      build_header_only::type_id or
+					    not file_dep.package_name.empty( ) or
+					    not file_dep.target.empty( ) ) {
+						result.push_back( file_dep.cmake_package( ) );
+					}
+				}
+				std::sort(
+				  result.begin( ), result.end( ),
+				  []( cmake_package_t const &lhs, cmake_package_t const &rhs ) {
+					  return lhs.name < rhs.name;
+				  } );
+				return result;
+			}
+
+			[[nodiscard]] action_status run_node( dependency const &cur_dep,
+			                                      daw::node_id_t id,
+			                                      daw::glean::build_types bt,
+			                                      node_keys_t &keys ) {
+				if( not cur_dep.has_file_dep( ) ) {
+					return action_status::success;
+				}
+				auto const label = log_label_scope( cur_dep.name( ) );
+				auto const &fp = keys.fingerprint;
+				auto const fp_file =
+				  fingerprint_file( *m_opts, cur_dep.file_dep( ), bt );
+				auto const previous_outputs = read_fingerprint(
+				  outputs_file( *m_opts, cur_dep.file_dep( ), bt ) );
+				if( not fp.empty( ) and read_fingerprint( fp_file ) == fp and
+				    cur_dep.is_installed( bt ) ) {
+					log_message << "Up to date - " << cur_dep.name( ) << " ("
+					            << to_string( bt ) << ")\n";
+					if( previous_outputs.empty( ) ) {
+						record_outputs( cur_dep, bt, keys );
+					} else {
+						keys.outputs = previous_outputs;
+						set_closure( keys );
+					}
+					return action_status::success;
+				}
+				// A build that fails part way must not leave an old match behind
+				if( exists( fp_file ) ) {
+					fs::remove( fp_file );
+				}
+				if( restore_artifact( cur_dep, bt, keys.artifact_key ) or
+				    ( keys.local_artifact_key != keys.artifact_key and
+				      restore_artifact( cur_dep, bt, keys.local_artifact_key ) ) ) {
+					if( not fp.empty( ) ) {
+						write_fingerprint( fp_file, fp );
+					}
+					record_outputs( cur_dep, bt, keys );
+					return action_status::success;
+				}
 
-		for( auto &node : daw::make_topological_sorted_range( known_deps ) ) {
-			auto const &cur_dep = node.value( );
-			if( cur_dep.has_file_dep( ) ) {
 				log_message << "\n-------------------------------------\n";
-				log_message << "Processing - " << cur_dep.name( ) << '\n';
+				log_message << "Processing - " << cur_dep.name( ) << " ("
+				            << to_string( bt ) << ")\n";
 				log_message << "-------------------------------------\n\n";
 
-				if( not to_bool( cur_dep.build( opts.build_type ) ) ) {
-					// Do error stuff
+				auto const start_time = std::chrono::steady_clock::now( );
+				if( not to_bool( cur_dep.build( bt ) ) ) {
+					log_error << "Error building " << cur_dep.name( ) << '\n';
+					return action_status::failure;
 				}
-				if( not to_bool( cur_dep.install( opts.build_type ) ) ) {
-					// Do error stuff
+				if( not to_bool( cur_dep.install( bt, dependency_packages( id ) ) ) ) {
+					log_error << "Error installing " << cur_dep.name( ) << '\n';
+					return action_status::failure;
 				}
+				if( not fp.empty( ) ) {
+					write_fingerprint( fp_file, fp );
+				}
+				record_outputs( cur_dep, bt, keys );
+				record_build_time( cache_folder( *m_opts, cur_dep.file_dep( ) ),
+				                   to_string( bt ),
+				                   std::chrono::duration_cast<std::chrono::seconds>(
+				                     std::chrono::steady_clock::now( ) - start_time ) );
+				store_artifact( cur_dep, bt, keys );
+				return action_status::success;
+			}
+
+			[[nodiscard]] std::string job_name( size_t config,
+			                                    daw::node_id_t id ) const {
+				return m_known_deps->get_raw_node( id ).value( ).name( ) + " (" +
+				       to_string( m_build_types[config] ) + ')';
+			}
+
+			// Other glean processes sharing the cache wait here instead of
+			// changing the source or build folder under this build.  After waiting
+			// the fingerprint usually shows their build can be reused
+			[[nodiscard]] action_status run_job( size_t config, daw::node_id_t id ) {
+				auto const &cur_dep = m_known_deps->get_raw_node( id ).value( );
+				auto source_lck = std::optional<cache_lock>( );
+				auto build_lck = std::optional<cache_lock>( );
+				if( cur_dep.has_file_dep( ) ) {
+					auto const folder = cache_folder( *m_opts, cur_dep.file_dep( ) );
+					source_lck.emplace( source_lock_file( folder ), lock_modes::shared );
+					build_lck.emplace( build_lock_file( folder, m_build_types[config] ),
+					                   lock_modes::exclusive );
+					mark_cache_used( folder );
+				}
+				auto node_keys = keys( config, id );
+				auto const result =
+				  run_node( cur_dep, id, m_build_types[config], node_keys );
+				if( to_bool( result ) ) {
+					auto const lck = std::lock_guard<std::mutex>( m_mutex );
+					m_keys[config][id] = std::move( node_keys );
+				}
+				return result;
 			}
+
+		public:
+			build_scheduler_t( daw::graph_t<dependency> const &known_deps,
+			                   std::vector<daw::glean::build_types> build_types,
+			                   glean_options const &opts )
+			  : m_known_deps( &known_deps )
+			  , m_opts( &opts )
+			  , m_build_types( std::move( build_types ) )
+			  , m_keys( m_build_types.size( ) ) {
+				if( not opts.artifact_cache.empty( ) ) {
+					m_artifacts.emplace( opts.artifact_cache );
+				}
+				if( not opts.artifact_server.empty( ) ) {
+					m_artifact_server.emplace( opts.artifact_server,
+					                           opts.transfer_jobs );
+					m_uploads.emplace( std::max( opts.transfer_jobs, 1U ) );
+				}
+			}
+
+			[[nodiscard]] action_status run( ) {
+				auto const result =
+				  graph_scheduler<dependency>(
+				    *m_known_deps, m_build_types.size( ), m_opts->build_jobs,
+				    [this]( size_t config, daw::node_id_t id ) {
+					    return run_job( config, id );
+				    },
+				    [this]( size_t config, daw::node_id_t id ) {
+					    return job_name( config, id );
+				    } )
+				    .run( );
+				if( m_uploads ) {
+					m_uploads->wait( );
+				}
+				return result;
+			}
+		};
+	} // namespace
+
+	action_status process_deps( daw::graph_t<dependency> const &known_deps,
+	                            glean_options const &opts ) {
+
+		auto build_types = std::vector<daw::glean::build_types>( );
+		if( opts.build_type == daw::glean::build_types::all ) {
+			build_types = {daw::glean::build_types::debug,
+			               daw::glean::build_types::release};
+		} else {
+			build_types = {opts.build_type};
 		}
+		return build_scheduler_t( known_deps, std::move( build_types ), opts )
+		  .run( );
 	}
 
 	namespace {
@@ -0,0 +1,77 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <daw/daw_read_file.h>
+#include <daw/json/daw_json_link.h>
+
+#include "daw/glean/glean_lock.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	action_status read_lock_file( fs::path const &lock_file_path,
+	                              glean_lock_file &lock ) {
+		if( not exists( lock_file_path ) ) {
+			log_error << "Could not find lock file '" << lock_file_path
+			          << "', run without --locked to create it\n";
+			return action_status::failure;
+		}
+		try {
+			lock = daw::json::from_json<glean_lock_file>(
+			  daw::read_file( lock_file_path.c_str( ) ).value( ) );
+		} catch( ... ) {
+			log_error << "Could not read lock file '" << lock_file_path << "'\n";
+			return action_status::failure;
+		}
+		return action_status::success;
+	}
+
+	action_status write_lock_file( fs::path const &lock_file_path,
+	                               glean_lock_file const &lock ) {
+		auto const content = daw::json::to_json( lock ) + '\n';
+		if( exists( lock_file_path ) ) {
+			auto in = std::ifstream( lock_file_path, std::ios::binary );
+			auto const old_content =
+			  std::string( std::istreambuf_iterator<char>( in ),
+			               std::istreambuf_iterator<char>( ) );
+			if( old_content == content ) {
+				return action_status::success;
+			}
+		}
+		auto const tmp_path = fs::path( lock_file_path.string( ) + ".tmp" );
+		{
+			auto out = std::ofstream( tmp_path, std::ios::trunc );
+			out << content;
+			if( not out ) {
+				log_error << "Could not write lock file '" << lock_file_path << "'\n";
+				return action_status::failure;
+			}
+		}
+		// Never leave a half written lock file behind
+		fs::rename( tmp_path, lock_file_path );
+		return action_status::success;
+	}
+} // namespace daw::glean
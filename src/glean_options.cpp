@@ -20,9 +20,11 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cstdlib>
 #include <sstream>
+#include <thread>
 
 #include <daw/daw_read_file.h>
 #include <daw/json/daw_json_link.h>
@@ -38,6 +40,14 @@ extern "C" char const GIT_VERSION[];
 
 namespace daw::glean {
 	namespace {
+		[[nodiscard]] uint32_t default_jobs( ) {
+			return std::max( 1U, std::thread::hardware_concurrency( ) );
+		}
+
+		[[nodiscard]] uint32_t default_build_jobs( ) {
+			return std::max( 1U, std::thread::hardware_concurrency( ) / 2U );
+		}
+
 		boost::program_options::variables_map get_vm( int argc, char **argv ) {
 			auto desc = boost::program_options::options_description( "Options" );
 
@@ -47,6 +57,20 @@ namespace daw::glean {
 			  boost::program_options::value<glean::fs::path>( )->default_value(
 			    glean::get_home( ) / ".glean_cache" ),
 			  "installation prefix folder" )(
+			  "artifact_cache", boost::program_options::value<glean::fs::path>( ),
+			  "folder, possibly shared between machines, to store the installed "
+			  "files of dependency builds in and restore them from instead of "
+			  "building" )(
+			  "artifact_server", boost::program_options::value<std::string>( ),
+			  "http:// address of a glean serve-cache to fetch artifacts from "
+			  "before building and upload them to after installing" )(
+			  "transfer_jobs",
+			  boost::program_options::value<uint32_t>( )->default_value( 4U ),
+			  "number of artifacts to transfer with the artifact server at once" )(
+			  "listen",
+			  boost::program_options::value<std::string>( )->default_value(
+			    "127.0.0.1:8765" ),
+			  "address:port that serve-cache listens on" )(
 			  "prefix",
 			  boost::program_options::value<glean::fs::path>( )->default_value(
 			    glean::fs::current_path( ) / ".glean" ),
@@ -58,24 +82,81 @@ namespace daw::glean {
 			  "output_type",
 			  boost::program_options::value<daw::glean::output_types>( )
 			    ->default_value( daw::glean::output_types::process ),
-			  "type of output" )( "dep_opts_file",
-			                      boost::program_options::value<glean::fs::path>( ),
-			                      "provide a dependency options override file" )(
+			  "type of output" )(
+			  "clone_strategy",
+			  boost::program_options::value<daw::glean::clone_strategies>( )
+			    ->default_value( daw::glean::clone_strategies::full ),
+			  "git history to clone for dependencies without a clone_strategy "
+			  "(full, shallow, blobless, single_branch)" )(
+			  "build_profile",
+			  boost::program_options::value<daw::glean::build_profiles>( )
+			    ->default_value( daw::glean::build_profiles::full ),
+			  "how much of each dependency to build (full, minimal).  minimal "
+			  "turns off tests, examples and docs and only builds what install "
+			  "needs" )(
+			  "dep_opts_file", boost::program_options::value<glean::fs::path>( ),
+			  "provide a dependency options override file" )(
 			  "cmake_arg",
 			  boost::program_options::value<std::vector<std::string>>( )
 			    ->multitoken( ),
 			  "additional commandline arguments to pass to cmake(1 per "
 			  "cmake_arg)" )(
-			  "jobs", boost::program_options::value<uint32_t>( )->default_value( 2U ),
-			  "number of build jobs to run, if supported by build ssytem" )(
+			  "jobs",
+			  boost::program_options::value<uint32_t>( )->default_value(
+			    default_jobs( ) ),
+			  "number of build jobs to run, shared by all dependency builds" )(
+			  "fetch_jobs",
+			  boost::program_options::value<uint32_t>( )->default_value( 4U ),
+			  "number of dependencies to download concurrently" )(
+			  "build_jobs",
+			  boost::program_options::value<uint32_t>( )->default_value(
+			    default_build_jobs( ) ),
+			  "number of dependencies to build concurrently" )(
+			  "jobserver",
+			  boost::program_options::value<bool>( )->default_value( true ),
+			  "share one make/ninja jobserver with --jobs slots between all "
+			  "dependency builds" )(
+			  "verbose",
+			  boost::program_options::value<bool>( )->default_value( false ),
+			  "show the output of every tool as it runs, instead of only for the "
+			  "ones that fail" )(
+			  "locked",
+			  boost::program_options::value<bool>( )->default_value( false ),
+			  "build the dependencies and revisions recorded in glean.lock "
+			  "instead of resolving glean.json" )(
+			  "relocatable",
+			  boost::program_options::value<bool>( )->default_value( false ),
+			  "build dependencies without paths of this machine in their "
+			  "outputs, so that compiler caches and artifacts are shared between "
+			  "machines and checkouts" )(
+			  "multi_config",
+			  boost::program_options::value<bool>( )->default_value( false ),
+			  "configure each dependency once with the Ninja Multi-Config "
+			  "generator and build debug and release from the same folder" )(
+			  "cache_size_limit", boost::program_options::value<std::string>( ),
+			  "size budget of the cache, such as 50G, for cache gc.  Defaults to "
+			  "the cache_size_limit of the glean config" )(
+			  "command",
+			  boost::program_options::value<std::vector<std::string>>( ),
+			  "what to do, build by default.  'cache gc' evicts the least "
+			  "recently used cache entries until the cache fits its size limit, "
+			  "'cache migrate' removes what older versions of glean left in the "
+			  "cache" )(
 			  "use_first_dependency",
 			  boost::program_options::value<bool>( )->default_value( false ),
 			  "use the first dependency that provides a resource" );
 
 			auto vm = boost::program_options::variables_map( );
 			try {
+				auto positional =
+				  boost::program_options::positional_options_description( );
+				positional.add( "command", -1 );
 				boost::program_options::store(
-				  boost::program_options::parse_command_line( argc, argv, desc ), vm );
+				  boost::program_options::command_line_parser( argc, argv )
+				    .options( desc )
+				    .positional( positional )
+				    .run( ),
+				  vm );
 
 				if( vm.count( "help" ) ) {
 					log_message << "glean - git tag/commit: " << GIT_VERSION << '\n';
@@ -146,10 +227,43 @@ namespace daw::glean {
 			glean::fs::create_directory( glean_cache );
 		}
 
+		if( not vm["command"].empty( ) ) {
+			command = vm["command"].template as<std::vector<std::string>>( );
+		}
+		if( not vm["artifact_cache"].empty( ) ) {
+			artifact_cache = vm["artifact_cache"].template as<fs::path>( );
+		}
+		if( not vm["artifact_server"].empty( ) ) {
+			artifact_server = vm["artifact_server"].template as<std::string>( );
+		}
+		transfer_jobs = vm["transfer_jobs"].template as<uint32_t>( );
+		listen = vm["listen"].template as<std::string>( );
+		bool const is_serve_cache =
+		  command == std::vector<std::string>{"serve-cache"};
+		if( artifact_cache.empty( ) and
+		    ( not artifact_server.empty( ) or is_serve_cache ) ) {
+			// Both ends of the artifact server keep archives in a local folder
+			artifact_cache = glean_cache / ".artifacts";
+		}
+
 		build_type = vm["build_type"].template as<daw::glean::build_types>( );
 		output_type = vm["output_type"].template as<daw::glean::output_types>( );
+		clone_strategy =
+		  vm["clone_strategy"].template as<daw::glean::clone_strategies>( );
+		build_profile =
+		  vm["build_profile"].template as<daw::glean::build_profiles>( );
 		use_first = vm["use_first_dependency"].template as<bool>( );
 		jobs = vm["jobs"].template as<uint32_t>( );
+		fetch_jobs = vm["fetch_jobs"].template as<uint32_t>( );
+		build_jobs = vm["build_jobs"].template as<uint32_t>( );
+		use_jobserver = vm["jobserver"].template as<bool>( );
+		verbose = vm["verbose"].template as<bool>( );
+		locked = vm["locked"].template as<bool>( );
+		relocatable = vm["relocatable"].template as<bool>( );
+		multi_config = vm["multi_config"].template as<bool>( );
+		if( not vm["cache_size_limit"].empty( ) ) {
+			cache_size_limit = vm["cache_size_limit"].template as<std::string>( );
+		}
 		if( not vm["cmake_arg"].empty( ) ) {
 			cmake_args = vm["cmake_arg"].template as<std::vector<std::string>>( );
 		}
@@ -253,4 +367,77 @@ namespace daw::glean {
 		}
 		std::abort( );
 	}
+
+	std::optional<clone_strategies>
+	clone_strategy_from_string( std::string_view str ) {
+		if( str == "full" ) {
+			return clone_strategies::full;
+		}
+		if( str == "shallow" ) {
+			return clone_strategies::shallow;
+		}
+		if( str == "blobless" ) {
+			return clone_strategies::blobless;
+		}
+		if( str == "single_branch" ) {
+			return clone_strategies::single_branch;
+		}
+		return std::nullopt;
+	}
+
+	std::ostream &operator<<( std::ostream &os, clone_strategies cs ) {
+		return os << to_string( cs );
+	}
+
+	std::istream &operator>>( std::istream &is, clone_strategies &cs ) {
+		std::string tmp{};
+		is >> tmp;
+		auto result = clone_strategy_from_string( tmp );
+		if( not result ) {
+			throw std::runtime_error( "Unknown clone strategy" );
+		}
+		cs = *result;
+		return is;
+	}
+
+	std::string to_string( clone_strategies cs ) {
+		switch( cs ) {
+		case clone_strategies::full:
+			return "full";
+		case clone_strategies::shallow:
+			return "shallow";
+		case clone_strategies::blobless:
+			return "blobless";
+		case clone_strategies::single_branch:
+			return "single_branch";
+		}
+		std::abort( );
+	}
+
+	std::ostream &operator<<( std::ostream &os, build_profiles bp ) {
+		return os << to_string( bp );
+	}
+
+	std::istream &operator>>( std::istream &is, build_profiles &bp ) {
+		std::string tmp{};
+		is >> tmp;
+		if( tmp == "full" ) {
+			bp = build_profiles::full;
+		} else if( tmp == "minimal" ) {
+			bp = build_profiles::minimal;
+		} else {
+			throw std::runtime_error( "Unknown build profile" );
+		}
+		return is;
+	}
+
+	std::string to_string( build_profiles bp ) {
+		switch( bp ) {
+		case build_profiles::full:
+			return "full";
+		case build_profiles::minimal:
+			return "minimal";
+		}
+		std::abort( );
+	}
 } // namespace daw::glean
@@ -0,0 +1,94 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "daw/glean/install_manifest.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	bool installed_files_contain( fs::path const &manifest,
+	                              std::vector<std::string> const &needles ) {
+		auto in = std::ifstream( manifest );
+		if( not in ) {
+			return true;
+		}
+		auto overlap = size_t( 0 );
+		for( auto const &needle : needles ) {
+			overlap = std::max( overlap, needle.size( ) );
+		}
+		auto buffer = std::string( );
+		auto chunk = std::string( 64U * 1024U, '\0' );
+		auto line = std::string( );
+		while( std::getline( in, line ) ) {
+			if( line.empty( ) or is_symlink( fs::path( line ) ) ) {
+				continue;
+			}
+			auto file = std::ifstream( line, std::ios::binary );
+			if( not file ) {
+				return true;
+			}
+			buffer.clear( );
+			while( file.read( chunk.data( ), chunk.size( ) ) or
+			       file.gcount( ) > 0 ) {
+				buffer.append( chunk.data( ),
+				               static_cast<size_t>( file.gcount( ) ) );
+				for( auto const &needle : needles ) {
+					if( buffer.find( needle ) != std::string::npos ) {
+						return true;
+					}
+				}
+				// Keep enough of the end to find a match across chunks
+				if( buffer.size( ) > overlap ) {
+					buffer.erase( 0, buffer.size( ) - overlap );
+				}
+			}
+		}
+		return false;
+	}
+
+	void remove_stale_files( fs::path const &manifest,
+	                         std::vector<fs::path> const &installed ) {
+		auto current = std::unordered_set<std::string>( );
+		for( auto const &file : installed ) {
+			current.insert( file.generic_string( ) );
+		}
+		auto in = std::ifstream( manifest );
+		auto line = std::string( );
+		while( std::getline( in, line ) ) {
+			if( line.empty( ) or current.count( line ) != 0 ) {
+				continue;
+			}
+			try {
+				fs::remove( fs::path( line ) );
+			} catch( std::exception const & ) {}
+		}
+	}
+
+	void remove_installed_files( fs::path const &manifest ) {
+		remove_stale_files( manifest, {} );
+	}
+} // namespace daw::glean
@@ -0,0 +1,183 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <boost/process.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "daw/glean/jobserver.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		// The first line of program --version, none when it is not found or
+		// cannot be run
+		[[nodiscard]] std::optional<std::string>
+		version_line( std::string const &program ) {
+			try {
+				auto const exe = boost::process::search_path( program );
+				if( exe.empty( ) ) {
+					return std::nullopt;
+				}
+				auto out = boost::process::ipstream( );
+				auto proc = boost::process::child(
+				  exe, "--version", boost::process::std_out > out,
+				  boost::process::std_err > boost::process::null,
+				  boost::process::std_in < boost::process::null );
+				auto line = std::string( );
+				std::getline( out, line );
+				proc.wait( );
+				return line;
+			} catch( std::exception const & ) { return std::string( ); }
+		}
+
+		// Whether the major.minor version at the start of str is at least that
+		[[nodiscard]] bool version_at_least( char const *str, unsigned major,
+		                                     unsigned minor ) {
+			unsigned found_major = 0;
+			unsigned found_minor = 0;
+			if( std::sscanf( str, "%u.%u", &found_major, &found_minor ) != 2 ) {
+				return false;
+			}
+			return found_major > major or
+			       ( found_major == major and found_minor >= minor );
+		}
+
+		// make before 4.4 only understands the anonymous pipe form of
+		// --jobserver-auth and treats the fifo form as a fatal error
+		[[nodiscard]] bool make_supports_fifo( ) {
+			auto const line = version_line( "make" );
+			if( not line ) {
+				return true;
+			}
+			static constexpr daw::string_view gnu_make = "GNU Make ";
+			if( line->compare( 0, gnu_make.size( ), gnu_make ) != 0 ) {
+				return not line->empty( );
+			}
+			return version_at_least( line->c_str( ) + gnu_make.size( ), 4, 4 );
+		}
+
+		// ninja takes job slots from MAKEFLAGS from 1.13 on, and then only from
+		// a fifo
+		[[nodiscard]] bool ninja_supports_jobserver( ) {
+			auto const line = version_line( "ninja" );
+			return line and version_at_least( line->c_str( ), 1, 13 );
+		}
+	} // namespace
+
+	jobserver::jobserver( uint32_t jobs, uint32_t concurrent_builds )
+	  : m_jobs( jobs ) {
+#ifndef _WIN32
+		if( jobs == 0 ) {
+			return;
+		}
+		m_use_fifo = make_supports_fifo( );
+		m_fifo_path = fs::temp_directory_path( ) /
+		              ( "glean_jobserver_" + std::to_string( ::getpid( ) ) );
+		if( ::mkfifo( m_fifo_path.c_str( ), S_IRUSR | S_IWUSR ) != 0 ) {
+			log_error << "Could not create jobserver fifo " << m_fifo_path
+			          << ", continuing without one\n";
+			m_fifo_path.clear( );
+			return;
+		}
+		// Opening read/write keeps the fifo alive for the life of glean and never
+		// blocks waiting for a peer
+		m_fd = ::open( m_fifo_path.c_str( ), O_RDWR );
+		if( m_fd < 0 ) {
+			log_error << "Could not open jobserver fifo " << m_fifo_path
+			          << ", continuing without one\n";
+			fs::remove( m_fifo_path );
+			m_fifo_path.clear( );
+			return;
+		}
+		auto const tokens = std::string(
+		  jobs > concurrent_builds ? jobs - concurrent_builds : 0U, '+' );
+		size_t written = 0;
+		while( written < tokens.size( ) ) {
+			auto const count =
+			  ::write( m_fd, tokens.data( ) + written, tokens.size( ) - written );
+			if( count <= 0 ) {
+				break;
+			}
+			written += static_cast<size_t>( count );
+		}
+#else
+		(void)concurrent_builds;
+#endif
+	}
+
+	jobserver::~jobserver( ) {
+#ifndef _WIN32
+		if( m_fd >= 0 ) {
+			::close( m_fd );
+		}
+		if( not m_fifo_path.empty( ) ) {
+			try {
+				fs::remove( m_fifo_path );
+			} catch( ... ) {}
+		}
+#endif
+	}
+
+	bool jobserver::is_active( ) const noexcept {
+		return m_fd >= 0;
+	}
+
+	bool jobserver::ninja_joins( ) const {
+		return is_active( ) and m_use_fifo and ninja_supports_jobserver( );
+	}
+
+	std::string jobserver::makeflags( ) const {
+		if( not is_active( ) ) {
+			return {};
+		}
+		auto result = " -j" + std::to_string( m_jobs ) + " --jobserver-auth=";
+		if( m_use_fifo ) {
+			result += "fifo:" + m_fifo_path.string( );
+		} else {
+			// The fifo is opened read/write so one descriptor serves both ends
+			result += std::to_string( m_fd ) + ',' + std::to_string( m_fd );
+		}
+		return result;
+	}
+
+	std::vector<std::pair<std::string, std::string>>
+	jobserver::environment( ) const {
+		if( not is_active( ) ) {
+			return {};
+		}
+		// CMAKE_BUILD_PARALLEL_LEVEL would otherwise make cmake pass its own -j
+		return {{"MAKEFLAGS", makeflags( )}, {"CMAKE_BUILD_PARALLEL_LEVEL", ""}};
+	}
+} // namespace daw::glean
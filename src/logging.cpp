@@ -20,60 +20,195 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#define fileisatty _isatty
+#define filefileno _fileno
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#define fileisatty isatty
+#define filefileno fileno
+#endif
 
 #include "daw/glean/logging.h"
 
 namespace daw::glean {
-	logger const &logger::operator( )( std::string const &message ) const {
-		switch( m_out_type ) {
-		case log_output_types::message:
-			std::cout << message;
-			break;
-		case log_output_types::error:
-			std::cerr << message;
-			break;
+	namespace {
+		// Everything written to the console goes through here so that lines
+		// from concurrent workers do not tear and the status line can be
+		// erased before anything else is printed
+		struct console_t {
+			std::mutex mutex{};
+			bool status_shown = false;
+			bool verbose = false;
+		};
+
+		console_t &console( ) {
+			static auto result = console_t( );
+			return result;
+		}
+
+		[[nodiscard]] bool status_supported( ) {
+			static bool const result = fileisatty( filefileno( stderr ) ) != 0;
+			return result;
+		}
+
+		[[nodiscard]] size_t console_width( ) {
+#ifdef TIOCGWINSZ
+			auto ws = winsize{};
+			if( ioctl( filefileno( stderr ), TIOCGWINSZ, &ws ) == 0 and
+			    ws.ws_col > 0 ) {
+				return ws.ws_col;
+			}
+#endif
+			return 80U;
+		}
+
+		// Must be called with the console mutex held
+		void erase_status( console_t &con ) {
+			if( con.status_shown ) {
+				std::cerr << "\r\x1b[K" << std::flush;
+				con.status_shown = false;
+			}
+		}
+
+		template<typename Stream, typename Message>
+		void write_console( Stream &os, Message const &message ) {
+			auto &con = console( );
+			auto const lck = std::lock_guard<std::mutex>( con.mutex );
+			erase_status( con );
+			os << message;
+			if( status_supported( ) and not con.verbose ) {
+				// The status line is drawn on stderr, keep it below the message
+				os.flush( );
+			}
+		}
+
+		// What a thread has logged since its last complete line.  A line built
+		// with several << is written with one lock, so lines of concurrent
+		// workers do not interleave.  Anything left is written when the thread
+		// ends
+		template<typename CharT>
+		struct line_buffer_t {
+			std::basic_ostream<CharT> *os;
+			std::basic_string<CharT> pending{};
+
+			explicit line_buffer_t( std::basic_ostream<CharT> &out )
+			  : os( &out ) {}
+
+			line_buffer_t( line_buffer_t const & ) = delete;
+			line_buffer_t &operator=( line_buffer_t const & ) = delete;
+
+			~line_buffer_t( ) {
+				if( not pending.empty( ) ) {
+					write_console( *os, pending );
+				}
+			}
+
+			template<typename Message>
+			void write( Message const &message ) {
+				pending += message;
+				auto const end = pending.find_last_of( CharT( '\n' ) );
+				if( end == std::basic_string<CharT>::npos ) {
+					return;
+				}
+				write_console( *os, pending.substr( 0, end + 1 ) );
+				pending.erase( 0, end + 1 );
+			}
+		};
+
+		template<typename CharT>
+		[[nodiscard]] line_buffer_t<CharT> &
+		line_buffer( log_output_types out_type ) {
+			if constexpr( std::is_same_v<CharT, char> ) {
+				thread_local auto message = line_buffer_t<CharT>( std::cout );
+				thread_local auto error = line_buffer_t<CharT>( std::cerr );
+				return out_type == log_output_types::message ? message : error;
+			} else {
+				thread_local auto message = line_buffer_t<CharT>( std::wcout );
+				thread_local auto error = line_buffer_t<CharT>( std::wcerr );
+				return out_type == log_output_types::message ? message : error;
+			}
 		}
+
+		thread_local std::string t_log_label{};
+	} // namespace
+
+	logger const &logger::operator( )( std::string const &message ) const {
+		line_buffer<char>( m_out_type ).write( message );
 		return *this;
 	}
 
 	logger const &logger::operator( )( std::wstring const &message ) const {
-		switch( m_out_type ) {
-		case log_output_types::message:
-			std::wcout << message;
-			break;
-		case log_output_types::error:
-			std::wcerr << message;
-			break;
-		}
+		line_buffer<wchar_t>( m_out_type ).write( message );
 		return *this;
 	}
 
 	logger const &logger::operator( )( char c ) const {
-		switch( m_out_type ) {
-		case log_output_types::message:
-			std::cout << c;
-			break;
-		case log_output_types::error:
-			std::cerr << c;
-			break;
-		}
+		line_buffer<char>( m_out_type ).write( c );
 		return *this;
 	}
 
 	logger const &logger::operator( )( wchar_t wc ) const {
-		switch( m_out_type ) {
-		case log_output_types::message:
-			std::wcout << wc;
-			break;
-		case log_output_types::error:
-			std::wcerr << wc;
-			break;
-		}
+		line_buffer<wchar_t>( m_out_type ).write( wc );
 		return *this;
 	}
 
+	void set_verbose_output( bool verbose ) noexcept {
+		auto &con = console( );
+		auto const lck = std::lock_guard<std::mutex>( con.mutex );
+		con.verbose = verbose;
+	}
+
+	bool verbose_output( ) noexcept {
+		auto &con = console( );
+		auto const lck = std::lock_guard<std::mutex>( con.mutex );
+		return con.verbose;
+	}
+
+	void log_status( std::string const &status ) {
+		if( not status_supported( ) ) {
+			return;
+		}
+		auto &con = console( );
+		auto const lck = std::lock_guard<std::mutex>( con.mutex );
+		if( con.verbose ) {
+			return;
+		}
+		erase_status( con );
+		if( status.empty( ) ) {
+			return;
+		}
+		std::cout.flush( );
+		auto const width = console_width( ) - 1U;
+		if( status.size( ) > width ) {
+			std::cerr << status.substr( 0, width );
+		} else {
+			std::cerr << status;
+		}
+		std::cerr.flush( );
+		con.status_shown = true;
+	}
+
+	log_label_scope::log_label_scope( std::string label )
+	  : m_previous( std::exchange( t_log_label, std::move( label ) ) ) {}
+
+	log_label_scope::~log_label_scope( ) {
+		t_log_label = std::move( m_previous );
+	}
+
+	std::string const &current_log_label( ) noexcept {
+		return t_log_label;
+	}
+
 	logger const &operator<<( logger const &l, fs::path const &path ) {
 		if constexpr( std::is_same_v<fs::path::value_type, char> ) {
 			return l( path.string( ) );
@@ -0,0 +1,547 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <array>
+#include <boost/process.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+#endif
+
+#include "daw/glean/logging.h"
+#include "daw/glean/proc.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		[[nodiscard]] std::string labelled( std::string const &label,
+		                                    std::string const &line ) {
+			if( label.empty( ) ) {
+				return line + '\n';
+			}
+			return '[' + label + "] " + line + '\n';
+		}
+
+		// Used where the event loop is not available.  stdout is captured and
+		// stderr goes straight to the console
+		[[nodiscard]] process_result
+		run_process_blocking( boost::filesystem::path const &exe,
+		                      std::vector<std::string> const &args,
+		                      process_options const &opts ) {
+			boost::process::environment env = boost::this_process::environment( );
+			for( auto const &[name, value] : opts.environment ) {
+				if( value.empty( ) ) {
+					env.erase( name );
+				} else {
+					env[name] = value;
+				}
+			}
+			auto out = boost::process::ipstream( );
+			auto child = [&]( ) {
+				if( opts.working_directory.empty( ) ) {
+					return boost::process::child(
+					  exe, args, env, boost::process::std_out > out,
+					  boost::process::std_in < boost::process::null );
+				}
+				return boost::process::child(
+				  exe, args, env, boost::process::std_out > out,
+				  boost::process::std_in < boost::process::null,
+				  boost::process::start_dir = opts.working_directory.string( ) );
+			}( );
+			auto result = process_result( );
+			auto const &label = current_log_label( );
+			auto const verbose = verbose_output( );
+			auto line = std::string( );
+			while( std::getline( out, line ) ) {
+				result.output += line;
+				result.output += '\n';
+				if( verbose ) {
+					log_message << labelled( label, line );
+				}
+			}
+			child.wait( );
+			result.exit_code = child.exit_code( );
+			return result;
+		}
+
+#ifdef __linux__
+		struct spawn_request_t {
+			std::string exe;
+			std::vector<std::string> args;
+			process_options opts;
+			std::string label;
+			std::promise<process_result> promise;
+		};
+
+		struct child_t {
+			pid_t pid = -1;
+			int pid_fd = -1;
+			int out_fd = -1;
+			int err_fd = -1;
+			bool has_exited = false;
+			// Reaped by someone else, so its exit status is unknown
+			bool is_status_lost = false;
+			int status = 0;
+			std::string label{};
+			std::string partial_out{};
+			std::string partial_err{};
+			// Every line, labelled, so it can be shown if the child fails
+			std::string transcript{};
+			std::string last_line{};
+			process_result result{};
+			std::promise<process_result> promise{};
+		};
+
+		[[nodiscard]] int open_pid_fd( pid_t pid ) {
+#ifdef SYS_pidfd_open
+			return static_cast<int>( ::syscall( SYS_pidfd_open, pid, 0 ) );
+#else
+			(void)pid;
+			return -1;
+#endif
+		}
+
+		/// Supervises every child process from one thread with epoll.  Exits are
+		/// seen through a pidfd, or by polling waitpid on kernels without them
+		class process_engine {
+			std::mutex m_mutex{};
+			std::deque<spawn_request_t> m_requests{};
+			bool m_stop = false;
+			int m_epoll_fd = -1;
+			int m_wake_fd = -1;
+			std::vector<std::unique_ptr<child_t>> m_children{};
+			std::unordered_map<int, child_t *> m_fd_owners{};
+			std::chrono::steady_clock::time_point m_last_status{};
+			size_t m_last_status_count = 0;
+			std::thread m_thread{};
+
+			void watch( int fd, child_t &child ) {
+				auto ev = epoll_event{};
+				ev.events = EPOLLIN;
+				ev.data.fd = fd;
+				if( ::epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, fd, &ev ) == 0 ) {
+					m_fd_owners[fd] = &child;
+				}
+			}
+
+			void unwatch( int &fd ) {
+				if( fd < 0 ) {
+					return;
+				}
+				::epoll_ctl( m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr );
+				m_fd_owners.erase( fd );
+				::close( fd );
+				fd = -1;
+			}
+
+			static void fail_request( spawn_request_t &req ) {
+				log_error << "Could not start " << req.exe << '\n';
+				req.promise.set_value( process_result{} );
+			}
+
+			void start_child( spawn_request_t &req ) {
+				int out_pipe[2];
+				int err_pipe[2];
+				if( ::pipe2( out_pipe, O_CLOEXEC ) != 0 ) {
+					fail_request( req );
+					return;
+				}
+				if( ::pipe2( err_pipe, O_CLOEXEC ) != 0 ) {
+					::close( out_pipe[0] );
+					::close( out_pipe[1] );
+					fail_request( req );
+					return;
+				}
+
+				// Everything the child needs is prepared before forking, only async
+				// signal safe calls are made in the child
+				auto argv_storage = std::vector<std::string>( );
+				argv_storage.push_back( req.exe );
+				argv_storage.insert( argv_storage.end( ), req.args.begin( ),
+				                     req.args.end( ) );
+				auto argv = std::vector<char *>( );
+				for( auto &arg : argv_storage ) {
+					argv.push_back( arg.data( ) );
+				}
+				argv.push_back( nullptr );
+
+				auto const is_overridden = [&]( std::string_view entry ) {
+					auto const name = entry.substr( 0, entry.find( '=' ) );
+					return std::any_of(
+					  req.opts.environment.begin( ), req.opts.environment.end( ),
+					  [&]( auto const &kv ) { return kv.first == name; } );
+				};
+				auto env_storage = std::vector<std::string>( );
+				for( char **e = environ; e != nullptr and *e != nullptr; ++e ) {
+					if( not is_overridden( *e ) ) {
+						env_storage.emplace_back( *e );
+					}
+				}
+				for( auto const &[name, value] : req.opts.environment ) {
+					if( not value.empty( ) ) {
+						env_storage.push_back( name + '=' + value );
+					}
+				}
+				auto envp = std::vector<char *>( );
+				for( auto &entry : env_storage ) {
+					envp.push_back( entry.data( ) );
+				}
+				envp.push_back( nullptr );
+				auto const work_dir = req.opts.working_directory.string( );
+
+				pid_t const pid = ::fork( );
+				if( pid == 0 ) {
+					::dup2( out_pipe[1], STDOUT_FILENO );
+					::dup2( err_pipe[1], STDERR_FILENO );
+					int const null_fd = ::open( "/dev/null", O_RDONLY );
+					if( null_fd >= 0 ) {
+						::dup2( null_fd, STDIN_FILENO );
+					}
+					if( not work_dir.empty( ) and ::chdir( work_dir.c_str( ) ) != 0 ) {
+						::_exit( 127 );
+					}
+					::execve( argv[0], argv.data( ), envp.data( ) );
+					::_exit( 127 );
+				}
+				::close( out_pipe[1] );
+				::close( err_pipe[1] );
+				if( pid < 0 ) {
+					::close( out_pipe[0] );
+					::close( err_pipe[0] );
+					fail_request( req );
+					return;
+				}
+				auto child = std::make_unique<child_t>( );
+				child->pid = pid;
+				child->label = std::move( req.label );
+				child->promise = std::move( req.promise );
+				child->out_fd = out_pipe[0];
+				child->err_fd = err_pipe[0];
+				::fcntl( child->out_fd, F_SETFL, O_NONBLOCK );
+				::fcntl( child->err_fd, F_SETFL, O_NONBLOCK );
+				watch( child->out_fd, *child );
+				watch( child->err_fd, *child );
+				child->pid_fd = open_pid_fd( pid );
+				if( child->pid_fd >= 0 ) {
+					watch( child->pid_fd, *child );
+				}
+				m_children.push_back( std::move( child ) );
+			}
+
+			static void add_line( child_t &child, std::string const &line,
+			                      bool is_error ) {
+				auto text = labelled( child.label, line );
+				if( not line.empty( ) ) {
+					child.last_line = line;
+				}
+				if( verbose_output( ) ) {
+					if( is_error ) {
+						log_error << text;
+					} else {
+						log_message << text;
+					}
+				}
+				child.transcript += text;
+			}
+
+			static void split_lines( child_t &child, std::string &partial,
+			                         bool is_error ) {
+				auto pos = partial.find( '\n' );
+				while( pos != std::string::npos ) {
+					add_line( child, partial.substr( 0, pos ), is_error );
+					partial.erase( 0, pos + 1 );
+					pos = partial.find( '\n' );
+				}
+			}
+
+			void read_pipe( child_t &child, int &fd ) {
+				bool const is_error = &fd == &child.err_fd;
+				auto &partial = is_error ? child.partial_err : child.partial_out;
+				auto buff = std::array<char, 4096>{};
+				while( fd >= 0 ) {
+					auto const count = ::read( fd, buff.data( ), buff.size( ) );
+					if( count > 0 ) {
+						auto const sz = static_cast<size_t>( count );
+						if( not is_error ) {
+							child.result.output.append( buff.data( ), sz );
+						}
+						partial.append( buff.data( ), sz );
+						split_lines( child, partial, is_error );
+						continue;
+					}
+					if( count < 0 and errno == EINTR ) {
+						continue;
+					}
+					if( count < 0 and ( errno == EAGAIN or errno == EWOULDBLOCK ) ) {
+						return;
+					}
+					// End of stream or an error we cannot recover from
+					unwatch( fd );
+				}
+			}
+
+			void reap( child_t &child ) {
+				if( child.has_exited ) {
+					return;
+				}
+				int status = 0;
+				auto const ret = ::waitpid( child.pid, &status, WNOHANG );
+				if( ret == child.pid ) {
+					child.has_exited = true;
+					child.status = status;
+					unwatch( child.pid_fd );
+				} else if( ret < 0 and errno == ECHILD ) {
+					child.has_exited = true;
+					child.is_status_lost = true;
+					unwatch( child.pid_fd );
+				}
+			}
+
+			// Once a child has exited whatever it wrote is already in the pipes,
+			// grandchildren that hold them open are not waited for
+			void finish( child_t &child ) {
+				read_pipe( child, child.out_fd );
+				read_pipe( child, child.err_fd );
+				unwatch( child.out_fd );
+				unwatch( child.err_fd );
+				if( not child.partial_out.empty( ) ) {
+					add_line( child, child.partial_out, false );
+				}
+				if( not child.partial_err.empty( ) ) {
+					add_line( child, child.partial_err, true );
+				}
+				if( child.is_status_lost ) {
+					log_error << labelled( child.label,
+					                       "Lost the exit status of process " +
+					                         std::to_string( child.pid ) +
+					                         ", treating it as failed" );
+				} else if( WIFEXITED( child.status ) ) {
+					child.result.exit_code = WEXITSTATUS( child.status );
+				} else if( WIFSIGNALED( child.status ) ) {
+					child.result.exit_code = 128 + WTERMSIG( child.status );
+				}
+				if( child.result.exit_code != 0 and not verbose_output( ) ) {
+					log_error << child.transcript;
+				}
+				child.promise.set_value( std::move( child.result ) );
+			}
+
+			void update_status( ) {
+				auto const now = std::chrono::steady_clock::now( );
+				if( m_children.size( ) == m_last_status_count and
+				    now - m_last_status < std::chrono::milliseconds( 100 ) ) {
+					return;
+				}
+				m_last_status = now;
+				m_last_status_count = m_children.size( );
+				if( m_children.empty( ) ) {
+					log_status( "" );
+					return;
+				}
+				auto const &child = *m_children.back( );
+				log_status( '[' + std::to_string( m_children.size( ) ) +
+				            " running] " + child.label + ": " + child.last_line );
+			}
+
+			void run( ) {
+				auto events = std::array<epoll_event, 64>{};
+				bool has_signalled = false;
+				while( true ) {
+					bool const must_poll =
+					  std::any_of( m_children.begin( ), m_children.end( ),
+					               []( auto const &c ) { return c->pid_fd < 0; } );
+					int const count = ::epoll_wait( m_epoll_fd, events.data( ),
+					                                static_cast<int>( events.size( ) ),
+					                                must_poll ? 50 : -1 );
+					for( int n = 0; n < count; ++n ) {
+						int const fd = events[static_cast<size_t>( n )].data.fd;
+						if( fd == m_wake_fd ) {
+							uint64_t value = 0;
+							(void)::read( m_wake_fd, &value, sizeof( value ) );
+							continue;
+						}
+						auto pos = m_fd_owners.find( fd );
+						if( pos == m_fd_owners.end( ) ) {
+							continue;
+						}
+						auto &child = *pos->second;
+						if( fd == child.pid_fd ) {
+							reap( child );
+						} else if( fd == child.out_fd ) {
+							read_pipe( child, child.out_fd );
+						} else if( fd == child.err_fd ) {
+							read_pipe( child, child.err_fd );
+						}
+					}
+
+					auto requests = std::deque<spawn_request_t>( );
+					bool is_stopping = false;
+					{
+						auto const lck = std::lock_guard<std::mutex>( m_mutex );
+						std::swap( requests, m_requests );
+						is_stopping = m_stop;
+					}
+					for( auto &req : requests ) {
+						start_child( req );
+					}
+					for( auto &child : m_children ) {
+						if( child->pid_fd < 0 ) {
+							reap( *child );
+						}
+					}
+					auto const last = std::partition(
+					  m_children.begin( ), m_children.end( ),
+					  []( auto const &c ) { return not c->has_exited; } );
+					for( auto it = last; it != m_children.end( ); ++it ) {
+						finish( **it );
+					}
+					m_children.erase( last, m_children.end( ) );
+					update_status( );
+
+					if( is_stopping ) {
+						if( m_children.empty( ) ) {
+							return;
+						}
+						if( not has_signalled ) {
+							for( auto const &child : m_children ) {
+								::kill( child->pid, SIGTERM );
+							}
+							has_signalled = true;
+						}
+					}
+				}
+			}
+
+		public:
+			process_engine( ) {
+				m_epoll_fd = ::epoll_create1( EPOLL_CLOEXEC );
+				m_wake_fd = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+				if( m_epoll_fd < 0 or m_wake_fd < 0 ) {
+					return;
+				}
+				auto ev = epoll_event{};
+				ev.events = EPOLLIN;
+				ev.data.fd = m_wake_fd;
+				if( ::epoll_ctl( m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &ev ) != 0 ) {
+					return;
+				}
+				m_thread = std::thread( [this]( ) { run( ); } );
+			}
+
+			~process_engine( ) {
+				if( m_thread.joinable( ) ) {
+					{
+						auto const lck = std::lock_guard<std::mutex>( m_mutex );
+						m_stop = true;
+					}
+					wake( );
+					m_thread.join( );
+				}
+				if( m_wake_fd >= 0 ) {
+					::close( m_wake_fd );
+				}
+				if( m_epoll_fd >= 0 ) {
+					::close( m_epoll_fd );
+				}
+			}
+
+			process_engine( process_engine const & ) = delete;
+			process_engine( process_engine && ) = delete;
+			process_engine &operator=( process_engine const & ) = delete;
+			process_engine &operator=( process_engine && ) = delete;
+
+			[[nodiscard]] bool is_running( ) const noexcept {
+				return m_thread.joinable( );
+			}
+
+			void wake( ) {
+				uint64_t const one = 1;
+				(void)::write( m_wake_fd, &one, sizeof( one ) );
+			}
+
+			[[nodiscard]] std::future<process_result>
+			spawn( std::string exe, std::vector<std::string> args,
+			       process_options opts, std::string label ) {
+				auto req = spawn_request_t{std::move( exe ), std::move( args ),
+				                           std::move( opts ), std::move( label ),
+				                           std::promise<process_result>( )};
+				auto result = req.promise.get_future( );
+				{
+					auto const lck = std::lock_guard<std::mutex>( m_mutex );
+					m_requests.push_back( std::move( req ) );
+				}
+				wake( );
+				return result;
+			}
+		};
+
+		process_engine &get_process_engine( ) {
+			static process_engine result{};
+			return result;
+		}
+#endif
+	} // namespace
+
+	process_result run_process( std::string const &cmd,
+	                            std::vector<std::string> args,
+	                            process_options const &opts ) {
+		auto const exe = boost::filesystem::path( cmd ).has_parent_path( )
+		                   ? boost::filesystem::path( cmd )
+		                   : boost::process::search_path( cmd );
+		if( exe.empty( ) ) {
+			log_error << "Could not find '" << cmd << "' in the PATH\n";
+			return process_result{};
+		}
+#ifdef __linux__
+		auto &engine = get_process_engine( );
+		if( engine.is_running( ) ) {
+			return engine
+			  .spawn( exe.string( ), std::move( args ), opts, current_log_label( ) )
+			  .get( );
+		}
+#endif
+		return run_process_blocking( exe, args, opts );
+	}
+} // namespace daw::glean
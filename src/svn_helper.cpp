@@ -32,6 +32,11 @@ namespace daw::glean {
 		return {"update", work_tree.string( )};
 	}
 
+	std::vector<std::string>
+	svn_action_revision::build_args( fs::path const &work_tree ) const {
+		return {"info", "--show-item", "revision", work_tree.string( )};
+	}
+
 	std::vector<std::string>
 	svn_action_checkout::build_args( fs::path const &work_tree ) const {
 		return {"checkout", remote_uri, work_tree.string( )};
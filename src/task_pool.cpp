@@ -0,0 +1,104 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "daw/glean/logging.h"
+#include "daw/glean/task_pool.h"
+
+namespace daw::glean {
+	task_pool::task_pool( uint32_t thread_count ) {
+		thread_count = std::max( thread_count, 1U );
+		m_threads.reserve( thread_count );
+		for( uint32_t n = 0; n < thread_count; ++n ) {
+			m_threads.emplace_back( [this]( ) { worker( ); } );
+		}
+	}
+
+	task_pool::~task_pool( ) {
+		{
+			auto const lck = std::lock_guard<std::mutex>( m_mutex );
+			m_stop = true;
+		}
+		m_has_work.notify_all( );
+		for( auto &t : m_threads ) {
+			if( t.joinable( ) ) {
+				t.join( );
+			}
+		}
+	}
+
+	void task_pool::worker( ) {
+		while( true ) {
+			auto task = std::function<void( )>( );
+			{
+				auto lck = std::unique_lock<std::mutex>( m_mutex );
+				m_has_work.wait( lck,
+				                 [&]( ) { return m_stop or not m_tasks.empty( ); } );
+				if( m_tasks.empty( ) ) {
+					return;
+				}
+				task = std::move( m_tasks.front( ) );
+				m_tasks.pop_front( );
+				++m_active;
+			}
+			try {
+				task( );
+			} catch( std::exception const &ex ) {
+				log_error << "Unhandled exception in worker: " << ex.what( ) << '\n';
+			} catch( ... ) {
+				// daw::json and others throw types not derived from std::exception
+				log_error << "Unhandled exception in worker\n";
+			}
+			{
+				auto const lck = std::lock_guard<std::mutex>( m_mutex );
+				--m_active;
+				if( m_active == 0 and m_tasks.empty( ) ) {
+					m_is_idle.notify_all( );
+				}
+			}
+		}
+	}
+
+	void task_pool::add_task( std::function<void( )> task ) {
+		{
+			auto const lck = std::lock_guard<std::mutex>( m_mutex );
+			m_tasks.push_back( std::move( task ) );
+		}
+		m_has_work.notify_one( );
+	}
+
+	void task_pool::wait( ) {
+		auto lck = std::unique_lock<std::mutex>( m_mutex );
+		m_is_idle.wait( lck,
+		                [&]( ) { return m_active == 0 and m_tasks.empty( ); } );
+	}
+
+	size_t task_pool::size( ) const noexcept {
+		return m_threads.size( );
+	}
+} // namespace daw::glean
@@ -0,0 +1,348 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <boost/process/search_path.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+#include "daw/glean/digest.h"
+#include "daw/glean/glean_options.h"
+#include "daw/glean/logging.h"
+#include "daw/glean/proc.h"
+#include "daw/glean/toolchain.h"
+#include "daw/glean/utilities.h"
+
+namespace daw::glean {
+	namespace {
+		constexpr char const probe_format[] = "glean toolchain 2";
+
+		// Variables that change which compiler cmake picks or how it is called
+		constexpr char const *const toolchain_variables[] = {
+		  "CC", "CXX", "CFLAGS", "CXXFLAGS", "LDFLAGS", "CMAKE_GENERATOR"};
+
+		// Compilers that answer --version and -dumpmachine
+		constexpr char const *const gcc_like_compilers[] = {
+		  "GNU", "Clang", "AppleClang", "IntelLLVM"};
+
+		constexpr char const probe_project[] =
+		  "cmake_minimum_required( VERSION 3.10 )\n"
+		  "project( glean_toolchain_probe LANGUAGES CXX )\n"
+		  "include( CheckLanguage )\n"
+		  "check_language( C )\n"
+		  "include( CheckCXXCompilerFlag )\n"
+		  "check_cxx_compiler_flag( -ffile-prefix-map=/a=/b CXX_PREFIX_MAP )\n"
+		  "if( CMAKE_C_COMPILER )\n"
+		  "\tenable_language( C )\n"
+		  "\tinclude( CheckCCompilerFlag )\n"
+		  "\tcheck_c_compiler_flag( -ffile-prefix-map=/a=/b C_PREFIX_MAP )\n"
+		  "else( )\n"
+		  "\tset( C_PREFIX_MAP ON )\n"
+		  "endif( )\n"
+		  "file( WRITE \"${CMAKE_BINARY_DIR}/toolchain.txt\"\n"
+		  "\t\"cmake=${CMAKE_VERSION}\\n\"\n"
+		  "\t\"c_compiler=${CMAKE_C_COMPILER}\\n\"\n"
+		  "\t\"c_id=${CMAKE_C_COMPILER_ID}\\n\"\n"
+		  "\t\"c_version=${CMAKE_C_COMPILER_VERSION}\\n\"\n"
+		  "\t\"cxx_compiler=${CMAKE_CXX_COMPILER}\\n\"\n"
+		  "\t\"cxx_id=${CMAKE_CXX_COMPILER_ID}\\n\"\n"
+		  "\t\"cxx_version=${CMAKE_CXX_COMPILER_VERSION}\\n\"\n"
+		  "\t\"cxx_target=${CMAKE_CXX_COMPILER_TARGET}\\n\"\n"
+		  "\t\"c_prefix_map=${C_PREFIX_MAP}\\n\"\n"
+		  "\t\"cxx_prefix_map=${CXX_PREFIX_MAP}\\n\"\n"
+		  "\t\"system=${CMAKE_SYSTEM_NAME}-${CMAKE_SYSTEM_PROCESSOR}\\n\" )\n";
+
+		using values_t = std::map<std::string, std::string>;
+
+		[[nodiscard]] std::string get_env( char const *name ) {
+			auto const value = std::getenv( name );
+			return value ? value : "";
+		}
+
+		// Changes whenever the file, or what a symlink to it points to, is
+		// replaced or rewritten.  Empty when it does not exist
+		[[nodiscard]] std::string file_identity( std::string const &file ) {
+			if( file.empty( ) ) {
+				return {};
+			}
+#ifdef _WIN32
+			struct _stat64 st {};
+			if( _wstat64( fs::path( file ).wstring( ).c_str( ), &st ) != 0 ) {
+				return {};
+			}
+#else
+			struct stat st {};
+			if( ::stat( file.c_str( ), &st ) != 0 ) {
+				return {};
+			}
+#endif
+			return std::to_string( st.st_dev ) + ':' + std::to_string( st.st_ino ) +
+			       ':' + std::to_string( st.st_size ) + ':' +
+			       std::to_string( st.st_mtime );
+		}
+
+		[[nodiscard]] std::vector<std::string>
+		cmake_arguments( glean_options const &opts ) {
+			auto result = std::vector<std::string>( );
+			for( auto const &arg : opts.cmake_args ) {
+				if( not arg.empty( ) ) {
+					result.push_back( arg );
+				}
+			}
+			return result;
+		}
+
+		// Everything that decides which compilers cmake picks, the name of the
+		// remembered probe result
+		[[nodiscard]] std::string request_key( glean_options const &opts,
+		                                       std::string const &cmake ) {
+			auto digest = sha256( );
+			digest.update_field( probe_format )
+			  .update_field( cmake )
+			  .update_field( file_identity( cmake ) )
+			  .update_field( "PATH" )
+			  .update_field( get_env( "PATH" ) );
+			for( char const *name : toolchain_variables ) {
+				digest.update_field( name ).update_field( get_env( name ) );
+			}
+			for( auto const &arg : cmake_arguments( opts ) ) {
+				digest.update_field( arg );
+			}
+			return digest.hex_digest( );
+		}
+
+		[[nodiscard]] values_t read_values( fs::path const &file ) {
+			auto result = values_t( );
+			auto in = std::ifstream( file );
+			auto line = std::string( );
+			while( std::getline( in, line ) ) {
+				if( auto const eq = line.find( '=' ); eq != std::string::npos ) {
+					result[line.substr( 0, eq )] = line.substr( eq + 1 );
+				}
+			}
+			return result;
+		}
+
+		// The values check_cxx_compiler_flag and friends set on success
+		[[nodiscard]] bool is_cmake_true( std::string const &value ) {
+			return value == "1" or value == "ON";
+		}
+
+		[[nodiscard]] bool is_gcc_like( std::string const &compiler_id ) {
+			for( char const *id : gcc_like_compilers ) {
+				if( compiler_id == id ) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// The first line compiler writes for arg, or empty when it fails
+		[[nodiscard]] std::string ask_compiler( std::string const &compiler,
+		                                        std::string const &arg ) {
+			auto result = run_process( compiler, {arg}, process_options( ) );
+			if( result.exit_code != EXIT_SUCCESS ) {
+				return {};
+			}
+			auto const eol = result.output.find_first_of( "\r\n" );
+			return result.output.substr( 0, eol );
+		}
+
+		// Vendors patch compilers without changing the version cmake reports,
+		// their --version banner usually tells them apart
+		[[nodiscard]] std::string compiler_version( values_t &values,
+		                                            std::string const &lang ) {
+			auto const &compiler = values[lang + "_compiler"];
+			if( compiler.empty( ) ) {
+				return {};
+			}
+			auto const &id = values[lang + "_id"];
+			if( is_gcc_like( id ) ) {
+				auto banner = ask_compiler( compiler, "--version" );
+				// GCC starts with the name it was called by, e.g. c++ or g++
+				auto const name = fs::path( compiler ).filename( ).string( ) + ' ';
+				if( banner.rfind( name, 0 ) == 0 ) {
+					banner.erase( 0, name.size( ) );
+				}
+				if( not banner.empty( ) ) {
+					return banner;
+				}
+			}
+			return id + ' ' + values[lang + "_version"];
+		}
+
+		[[nodiscard]] std::string compiler_target( values_t &values ) {
+			if( not values["cxx_target"].empty( ) ) {
+				return values["cxx_target"];
+			}
+			if( is_gcc_like( values["cxx_id"] ) ) {
+				if( auto triple =
+				      ask_compiler( values["cxx_compiler"], "-dumpmachine" );
+				    not triple.empty( ) ) {
+					return triple;
+				}
+			}
+			return values["system"];
+		}
+
+		[[nodiscard]] std::optional<toolchain_t>
+		run_probe( glean_options const &opts, fs::path const &probe_folder ) {
+			fs::create_directories( probe_folder );
+			{
+				auto out = std::ofstream( probe_folder / "CMakeLists.txt" );
+				out << probe_project;
+			}
+			auto args =
+			  std::vector<std::string>{"-S", probe_folder.string( ), "-B",
+			                           ( probe_folder / "build" ).string( )};
+			for( auto &arg : cmake_arguments( opts ) ) {
+				args.push_back( std::move( arg ) );
+			}
+			if( run_process( "cmake", std::move( args ), in_folder( probe_folder ) )
+			      .exit_code != EXIT_SUCCESS ) {
+				return std::nullopt;
+			}
+			auto values = read_values( probe_folder / "build" / "toolchain.txt" );
+			if( values["cxx_compiler"].empty( ) ) {
+				return std::nullopt;
+			}
+			auto result = toolchain_t( );
+			result.c_compiler = values["c_compiler"];
+			result.c_version = compiler_version( values, "c" );
+			result.cxx_compiler = values["cxx_compiler"];
+			result.cxx_version = compiler_version( values, "cxx" );
+			result.target = compiler_target( values );
+			result.has_prefix_map = is_cmake_true( values["c_prefix_map"] ) and
+			                        is_cmake_true( values["cxx_prefix_map"] );
+
+			// Paths differ between machines that build the same way, so only
+			// what the compilers report about themselves is part of the id
+			auto digest = sha256( );
+			digest.update_field( probe_format )
+			  .update_field( values["cmake"] )
+			  .update_field( values["c_id"] )
+			  .update_field( result.c_version )
+			  .update_field( values["cxx_id"] )
+			  .update_field( result.cxx_version )
+			  .update_field( result.target );
+			for( char const *name : toolchain_variables ) {
+				digest.update_field( name ).update_field( get_env( name ) );
+			}
+			for( auto const &arg : cmake_arguments( opts ) ) {
+				digest.update_field( arg );
+			}
+			result.id = digest.hex_digest( );
+			return result;
+		}
+
+		// A remembered probe is only good while the compilers it found are the
+		// same files
+		[[nodiscard]] std::optional<toolchain_t>
+		read_probe( fs::path const &file ) {
+			if( not exists( file ) ) {
+				return std::nullopt;
+			}
+			auto values = read_values( file );
+			if( values["id"].empty( ) or values.count( "prefix_map" ) == 0 or
+			    values["c_identity"] != file_identity( values["c_compiler"] ) or
+			    values["cxx_identity"] != file_identity( values["cxx_compiler"] ) ) {
+				return std::nullopt;
+			}
+			auto result = toolchain_t( );
+			result.id = values["id"];
+			result.c_compiler = values["c_compiler"];
+			result.c_version = values["c_version"];
+			result.cxx_compiler = values["cxx_compiler"];
+			result.cxx_version = values["cxx_version"];
+			result.target = values["target"];
+			result.has_prefix_map = values["prefix_map"] == "1";
+			return result;
+		}
+
+		// Another glean may be probing too, each writes its own file and renames
+		// it into place when complete
+		void write_probe( fs::path const &file, toolchain_t const &toolchain ) {
+			auto const partial = fs::path(
+			  file.string( ) + '.' + std::to_string( std::random_device( )( ) ) );
+			{
+				auto out = std::ofstream( partial, std::ios::trunc );
+				out << "id=" << toolchain.id << '\n'
+				    << "c_compiler=" << toolchain.c_compiler << '\n'
+				    << "c_identity=" << file_identity( toolchain.c_compiler ) << '\n'
+				    << "c_version=" << toolchain.c_version << '\n'
+				    << "cxx_compiler=" << toolchain.cxx_compiler << '\n'
+				    << "cxx_identity=" << file_identity( toolchain.cxx_compiler )
+				    << '\n'
+				    << "cxx_version=" << toolchain.cxx_version << '\n'
+				    << "target=" << toolchain.target << '\n'
+				    << "prefix_map=" << ( toolchain.has_prefix_map ? 1 : 0 ) << '\n';
+				if( not out ) {
+					return;
+				}
+			}
+			fs::rename( partial, file );
+		}
+
+		[[nodiscard]] toolchain_t find_toolchain( glean_options const &opts ) {
+			auto const key =
+			  request_key( opts, boost::process::search_path( "cmake" ).string( ) );
+			auto const probes_folder = opts.glean_cache / ".toolchains";
+			auto const probe_file = probes_folder / key;
+			if( auto remembered = read_probe( probe_file ); remembered ) {
+				return *remembered;
+			}
+			log_message << "Probing the toolchain\n";
+			auto const probe_folder =
+			  probes_folder /
+			  ( key + ".probe." + std::to_string( std::random_device( )( ) ) );
+			auto result = run_probe( opts, probe_folder );
+			if( exists( probe_folder ) ) {
+				fs::remove_all( probe_folder );
+			}
+			if( not result ) {
+				// Builds will most likely fail too, but they will say why
+				log_message << "Could not probe the toolchain with cmake\n";
+				auto fallback = toolchain_t( );
+				fallback.id = key;
+				return fallback;
+			}
+			write_probe( probe_file, *result );
+			return *result;
+		}
+	} // namespace
+
+	toolchain_t const &probe_toolchain( glean_options const &opts ) {
+		static auto const result = find_toolchain( opts );
+		return result;
+	}
+
+	std::string const &toolchain_id( glean_options const &opts ) {
+		return probe_toolchain( opts ).id;
+	}
+} // namespace daw::glean
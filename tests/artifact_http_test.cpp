@@ -0,0 +1,262 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <daw/daw_benchmark.h>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/artifact_cache.h"
+#include "daw/glean/artifact_http.h"
+#include "daw/glean/utilities.h"
+
+namespace {
+	namespace fs = daw::glean::fs;
+	using daw::glean::to_bool;
+
+	fs::path make_temp_folder( std::string const &name ) {
+		auto rd = std::random_device( );
+		auto result = fs::temp_directory_path( ) /
+		              ( "glean_" + name + '_' + std::to_string( rd( ) ) );
+		fs::create_directories( result );
+		return result;
+	}
+
+	void write_file( fs::path const &file, std::string const &content ) {
+		auto out = std::ofstream( file, std::ios::binary | std::ios::trunc );
+		out << content;
+	}
+
+	std::string read_file( fs::path const &file ) {
+		auto in = std::ifstream( file, std::ios::binary );
+		return std::string( std::istreambuf_iterator<char>( in ),
+		                    std::istreambuf_iterator<char>( ) );
+	}
+
+	// A port nothing listens on right now
+	uint16_t free_port( ) {
+		auto ioc = boost::asio::io_context( );
+		auto acceptor = boost::asio::ip::tcp::acceptor(
+		  ioc, boost::asio::ip::tcp::endpoint(
+		         boost::asio::ip::make_address( "127.0.0.1" ), 0 ) );
+		return acceptor.local_endpoint( ).port( );
+	}
+
+	std::string make_key( int n ) {
+		auto result = std::string( 64, '0' );
+		auto const digits = std::to_string( n );
+		result.replace( result.size( ) - digits.size( ), digits.size( ), digits );
+		return result;
+	}
+
+	struct fixture_t {
+		fs::path folder = make_temp_folder( "artifact_http" );
+		daw::glean::artifact_cache server_store{folder / "server"};
+		uint16_t port = free_port( );
+		std::string url = "http://127.0.0.1:" + std::to_string( port );
+
+		fixture_t( ) {
+			// serve_artifact_cache runs until the process ends
+			std::thread( [this]( ) {
+				(void)daw::glean::serve_artifact_cache( server_store, "127.0.0.1",
+				                                        port );
+			} ).detach( );
+			for( int n = 0; n < 100; ++n ) {
+				auto ioc = boost::asio::io_context( );
+				auto socket = boost::asio::ip::tcp::socket( ioc );
+				auto ec = boost::system::error_code( );
+				socket.connect(
+				  boost::asio::ip::tcp::endpoint(
+				    boost::asio::ip::make_address( "127.0.0.1" ), port ),
+				  ec );
+				if( not ec ) {
+					break;
+				}
+				std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+			}
+		}
+	};
+
+	// Answers every request slowly with 200 OK and records how many it was
+	// answering at once
+	struct counting_server_t {
+		uint16_t port = free_port( );
+		std::string url = "http://127.0.0.1:" + std::to_string( port );
+		std::atomic<int> current{0};
+		std::atomic<int> most{0};
+
+		counting_server_t( ) {
+			auto ready = std::atomic<bool>( false );
+			// Runs until the process ends
+			std::thread( [this, &ready]( ) {
+				auto ioc = boost::asio::io_context( );
+				auto acceptor = boost::asio::ip::tcp::acceptor(
+				  ioc, boost::asio::ip::tcp::endpoint(
+				         boost::asio::ip::make_address( "127.0.0.1" ), port ) );
+				ready = true;
+				while( true ) {
+					auto socket = boost::asio::ip::tcp::socket( ioc );
+					acceptor.accept( socket );
+					std::thread( [this, socket = std::move( socket )]( ) mutable {
+						auto ec = boost::system::error_code( );
+						auto request = boost::asio::streambuf( );
+						boost::asio::read_until( socket, request, "\r\n\r\n", ec );
+						auto const now = ++current;
+						auto seen = most.load( );
+						while( now > seen and
+						       not most.compare_exchange_weak( seen, now ) ) {
+						}
+						std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+						--current;
+						static constexpr char const response[] =
+						  "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n"
+						  "Connection: close\r\n\r\n";
+						boost::asio::write(
+						  socket, boost::asio::buffer( response, sizeof( response ) - 1 ),
+						  ec );
+					} ).detach( );
+				}
+			} ).detach( );
+			while( not ready ) {
+				std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+			}
+		}
+	};
+
+	void artifact_http_test_001( fixture_t const &fx ) {
+		auto client = daw::glean::artifact_client( fx.url, 2 );
+		auto const key = make_key( 1 );
+		auto const upload = fx.folder / "upload_1";
+		auto const download = fx.folder / "download_1";
+		write_file( upload, "archive one" );
+		daw::expecting( not client.contains( key ) );
+		daw::expecting( to_bool( client.upload( key, upload ) ) );
+		daw::expecting( client.contains( key ) );
+		daw::expecting( to_bool( client.download( key, download ) ) );
+		daw::expecting( read_file( download ) == "archive one" );
+		daw::expecting( not to_bool(
+		  client.download( make_key( 999 ), fx.folder / "download_999" ) ) );
+	}
+
+	// A second upload of a key does not replace its archive
+	void artifact_http_test_002( fixture_t const &fx ) {
+		auto client = daw::glean::artifact_client( fx.url, 2 );
+		auto const key = make_key( 2 );
+		auto const upload = fx.folder / "upload_2";
+		auto const download = fx.folder / "download_2";
+		write_file( upload, "archive two" );
+		daw::expecting( to_bool( client.upload( key, upload ) ) );
+		write_file( upload, "replacement" );
+		daw::expecting( to_bool( client.upload( key, upload ) ) );
+		daw::expecting( to_bool( client.download( key, download ) ) );
+		daw::expecting( read_file( download ) == "archive two" );
+	}
+
+	// An archive changed after it was stored is not handed out
+	void artifact_http_test_003( fixture_t const &fx ) {
+		auto client = daw::glean::artifact_client( fx.url, 2 );
+		auto const key = make_key( 3 );
+		auto const upload = fx.folder / "upload_3";
+		write_file( upload, "archive three" );
+		daw::expecting( to_bool( client.upload( key, upload ) ) );
+		write_file( fx.server_store.archive_path( key ), "archive 3hree" );
+		daw::expecting(
+		  not to_bool( client.download( key, fx.folder / "download_3" ) ) );
+	}
+
+	// More transfers at once than the client allows
+	void artifact_http_test_004( fixture_t const &fx ) {
+		auto client = daw::glean::artifact_client( fx.url, 3 );
+		auto threads = std::vector<std::thread>( );
+		auto results = std::vector<int>( 16, 0 );
+		for( int n = 0; n < 16; ++n ) {
+			threads.emplace_back( [&, n]( ) {
+				auto const key = make_key( 100 + n );
+				auto const upload =
+				  fx.folder / ( "upload_4_" + std::to_string( n ) );
+				auto const download =
+				  fx.folder / ( "download_4_" + std::to_string( n ) );
+				auto const content =
+				  std::string( 100000U + static_cast<size_t>( n ), 'a' + n );
+				write_file( upload, content );
+				results[static_cast<size_t>( n )] =
+				  to_bool( client.upload( key, upload ) ) and
+				  to_bool( client.download( key, download ) ) and
+				  read_file( download ) == content;
+			} );
+		}
+		for( auto &t : threads ) {
+			t.join( );
+		}
+		for( auto result : results ) {
+			daw::expecting( result == 1 );
+		}
+	}
+
+	// The server never sees more requests at once than the client allows
+	void artifact_http_test_005( ) {
+		auto server = counting_server_t( );
+		auto client = daw::glean::artifact_client( server.url, 3 );
+		auto threads = std::vector<std::thread>( );
+		auto results = std::vector<int>( 16, 0 );
+		for( int n = 0; n < 16; ++n ) {
+			threads.emplace_back( [&, n]( ) {
+				results[static_cast<size_t>( n )] =
+				  client.contains( make_key( 200 + n ) );
+			} );
+		}
+		for( auto &t : threads ) {
+			t.join( );
+		}
+		for( auto result : results ) {
+			daw::expecting( result == 1 );
+		}
+		daw::expecting( server.most.load( ) == 3 );
+	}
+} // namespace
+
+int main( ) {
+	auto const fx = fixture_t( );
+	artifact_http_test_001( fx );
+	artifact_http_test_002( fx );
+	artifact_http_test_003( fx );
+	artifact_http_test_004( fx );
+	artifact_http_test_005( );
+	fs::remove_all( fx.folder );
+	std::cout << "artifact_http tests passed" << std::endl;
+	std::quick_exit( EXIT_SUCCESS );
+}
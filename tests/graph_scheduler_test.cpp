@@ -0,0 +1,124 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <daw/daw_benchmark.h>
+#include <daw/daw_graph.h>
+
+#include "daw/glean/action_status.h"
+#include "daw/glean/graph_scheduler.h"
+
+namespace {
+	using daw::glean::action_status;
+	using daw::glean::graph_scheduler;
+
+	struct run_result_t {
+		action_status status;
+		std::set<std::string> ran;
+	};
+
+	// Runs every node's task, where a node named fail returns failure and one
+	// named throw throws
+	run_result_t run_graph( daw::graph_t<std::string> const &graph ) {
+		auto mut = std::mutex( );
+		auto result = run_result_t{};
+		auto const name = [&]( size_t, daw::node_id_t id ) {
+			return graph.get_raw_node( id ).value( );
+		};
+		result.status =
+		  graph_scheduler<std::string>(
+		    graph, 1, 4,
+		    [&]( size_t config, daw::node_id_t id ) {
+			    auto const node_name = name( config, id );
+			    {
+				    auto const lck = std::lock_guard<std::mutex>( mut );
+				    result.ran.insert( node_name );
+			    }
+			    if( node_name == "throw" ) {
+				    throw std::runtime_error( "task threw" );
+			    }
+			    return daw::glean::to_action_status( node_name != "fail" );
+		    },
+		    name )
+		    .run( );
+		return result;
+	}
+
+	// app -> lib -> leaf and app -> other.  Edges point at what a node
+	// depends on
+	daw::graph_t<std::string> make_graph( std::string const &leaf ) {
+		auto graph = daw::graph_t<std::string>( );
+		auto const app = graph.add_node( "app" );
+		auto const lib = graph.add_node( "lib" );
+		auto const leaf_id = graph.add_node( leaf );
+		auto const other = graph.add_node( "other" );
+		graph.add_directed_edge( app, lib );
+		graph.add_directed_edge( lib, leaf_id );
+		graph.add_directed_edge( app, other );
+		return graph;
+	}
+
+	void scheduler_test_001( ) {
+		auto const result = run_graph( make_graph( "leaf" ) );
+		daw::expecting( daw::glean::to_bool( result.status ) );
+		daw::expecting(
+		  result.ran == std::set<std::string>{"app", "lib", "leaf", "other"} );
+	}
+
+	void scheduler_test_002( ) {
+		auto const result = run_graph( make_graph( "fail" ) );
+		daw::expecting( not daw::glean::to_bool( result.status ) );
+		daw::expecting( result.ran == std::set<std::string>{"fail", "other"} );
+	}
+
+	void scheduler_test_003( ) {
+		auto const result = run_graph( make_graph( "throw" ) );
+		daw::expecting( not daw::glean::to_bool( result.status ) );
+		daw::expecting( result.ran == std::set<std::string>{"throw", "other"} );
+	}
+
+	void scheduler_test_004( ) {
+		auto graph = make_graph( "leaf" );
+		auto const cycle = graph.add_node( "cycle" );
+		auto const lib = graph.find( []( auto const &node ) {
+			return node.value( ) == "lib";
+		} );
+		graph.add_directed_edge( lib.front( ), cycle );
+		graph.add_directed_edge( cycle, lib.front( ) );
+		auto const result = run_graph( graph );
+		daw::expecting( not daw::glean::to_bool( result.status ) );
+		daw::expecting( result.ran == std::set<std::string>{"leaf", "other"} );
+	}
+} // namespace
+
+int main( ) {
+	scheduler_test_001( );
+	scheduler_test_002( );
+	scheduler_test_003( );
+	scheduler_test_004( );
+	std::cout << "graph_scheduler tests passed\n";
+}